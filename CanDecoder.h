@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include "CanFrameRing.h"
+
+const uint16_t CAN_ID_ENGINE = 0x540;
+const uint16_t CAN_ID_OBD_RESPONSE = 0x7E8;
+const uint16_t CAN_ID_OBD_REQUEST = 0x7DF;
+
+// The library programs one mask into both MCP2515 masks. 0x540 and 0x7E8
+// differ only in the bits of 0x2A8, so this pair passes both and rejects the
+// 0x541 and 0x12A-0x12D traffic. 14 other unused IDs still get through and
+// are dropped in software.
+const uint16_t CAN_FILTER_ID = 0x540;
+const uint16_t CAN_FILTER_MASK = 0x7FF & ~(CAN_ID_ENGINE ^ CAN_ID_OBD_RESPONSE);
+
+struct CanState {
+  uint8_t gear = 0;
+  uint16_t rpm = 0;
+  float coolantTemp = -1;
+  float throttle = -1;
+  float ambiTemp = -1;
+  float engineLoad = -1;
+  uint32_t ignored = 0;
+};
+
+inline void decodeOBDResponse(const uint8_t* res, CanState& state) {
+  if (res[1] != 0x41) return;
+
+  switch (res[2]) {
+    case 0x11: state.throttle = res[3] * 100.0 / 255.0; break;
+    case 0x0F: state.ambiTemp = res[3] - 40; break;
+    case 0x04: state.engineLoad = res[3] * 100.0 / 255.0; break;
+  }
+}
+
+inline bool decodeEngine540(const uint8_t* data, CanState& state) {
+  if (data[0] != 0x02) return false;
+
+  state.gear = data[3] & 0x0F;
+  state.rpm = (data[1] << 8) | data[2];
+  state.coolantTemp = ((data[6] << 8) | data[7]) / 10.0;
+  return true;
+}
+
+// Returns true when the frame carried a new engine sample, the moment a
+// telemetry line is due.
+inline bool decodeCanFrame(const CanFrame& frame, CanState& state) {
+  if (frame.id == CAN_ID_OBD_RESPONSE && frame.length >= 4) {
+    decodeOBDResponse(frame.data, state);
+    return false;
+  }
+  if (frame.id == CAN_ID_ENGINE && frame.length == 8) {
+    return decodeEngine540(frame.data, state);
+  }
+  state.ignored++;
+  return false;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Keeps the compiler from moving the frame copy past the index update.
+// AVR cores don't reorder memory accesses themselves.
+#define CAN_RING_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+struct CanFrame {
+  uint16_t id;
+  uint8_t length;
+  uint8_t data[8];
+};
+
+// Single producer (CAN receive interrupt), single consumer (loop()). The
+// indices are 8 bit so reads and writes of them are atomic on AVR, N has to
+// be a power of two <= 128.
+template <uint8_t N>
+class CanFrameRing {
+public:
+  bool push(const CanFrame& frame) {
+    uint8_t head = this->head;
+    uint8_t next = (head + 1) & (N - 1);
+    if (next == tail) {
+      dropped++;
+      return false;
+    }
+    frames[head] = frame;
+    CAN_RING_BARRIER();
+    this->head = next;
+    received++;
+    return true;
+  }
+
+  bool pop(CanFrame& frame) {
+    uint8_t tail = this->tail;
+    if (tail == head) return false;
+    CAN_RING_BARRIER();
+    frame = frames[tail];
+    CAN_RING_BARRIER();
+    this->tail = (tail + 1) & (N - 1);
+    return true;
+  }
+
+  // Written by the producer only, read them with interrupts disabled on AVR
+  volatile uint32_t received = 0;
+  volatile uint32_t dropped = 0;
+private:
+  CanFrame frames[N];
+  volatile uint8_t head = 0;
+  volatile uint8_t tail = 0;
+};
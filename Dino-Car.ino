@@ -1,11 +1,17 @@
 #include <CAN.h>
 #include <Servo.h>
+#include "CanFrameRing.h"
+#include "CanDecoder.h"
+#include "SerialCommandParser.h"
+#include "ShiftExecutor.h"
 
 Servo gearServo;
 int gearServoPos = 90;
 const int gearServoPin = 3;
 unsigned long lastServoCommandTime = 0;
 bool servoAttached = false;
+ShiftExecutor shiftExecutor;
+int appliedShiftAngle = SERVO_DETACHED;
 
 unsigned long lastRequestTime = 0;
 int currentPIDIndex = 0;
@@ -17,90 +23,154 @@ const int batteryPin = A0;
 const float R1 = 47000.0; // 47k ohm
 const float R2 = 10000.0; // 10k ohm
 
-float throttle = -1;
-float ambiTemp = -1;
-float engineLoad = -1;
 float batteryVoltage = -1;
+unsigned long lastBatteryTime = 0;
+const unsigned long BATTERY_INTERVAL_MS = 10;
+
+CanFrameRing<32> canRing;
+CanState canState;
+unsigned long lastStatusTime = 0;
+const unsigned long STATUS_INTERVAL_MS = 1000;
 
 void sendPIDRequest() {
   uint8_t frame[8] = { 0x02, 0x01, pidList[currentPIDIndex], 0, 0, 0, 0, 0 };
-  CAN.beginPacket(0x7DF);
+  CAN.beginPacket(CAN_ID_OBD_REQUEST);
   CAN.write(frame, 8);
   CAN.endPacket();
   currentPIDIndex = (currentPIDIndex + 1) % numPIDs;
 }
 
-void handleOBDResponse(uint8_t* res) {
-  if (res[1] != 0x41) return;
+void printTelemetry() {
+  Serial.print("G:"); Serial.print(canState.gear);
+  Serial.print(",R:"); Serial.print(canState.rpm);
+  Serial.print(",T:"); Serial.print(canState.coolantTemp);
+  Serial.print(",Th:"); Serial.print(canState.throttle);
+  Serial.print(",L:"); Serial.print(canState.engineLoad);
+  Serial.print(",A:"); Serial.print(canState.ambiTemp);
+  Serial.print(",V:"); Serial.println(batteryVoltage);
+}
+
+// Runs in the MCP2515 interrupt, only copies the frame out of the controller
+void onCANReceive(int packetSize) {
+  if (CAN.packetRtr()) return;
+  CanFrame frame;
+  frame.id = CAN.packetId();
+  frame.length = 0;
+  memset(frame.data, 0, sizeof(frame.data));
+  while (CAN.available() && frame.length < 8) frame.data[frame.length++] = CAN.read();
+  canRing.push(frame);
+}
 
-  switch (res[2]) {
-    case 0x11: throttle = res[3] * 100.0 / 255.0; break;
-    case 0x0F: ambiTemp = res[3] - 40; break;
-    case 0x04: engineLoad = res[3] * 100.0 / 255.0; break;
+void moveServo(int pos) {
+  if (!servoAttached) {
+    gearServo.attach(gearServoPin);
+    servoAttached = true;
   }
+  gearServo.write(pos);
+  gearServoPos = pos;
+  lastServoCommandTime = millis();
 }
 
-void handleCustom540(uint8_t* data) {
-  if (data[0] != 0x02) return;
+void applyShiftServo() {
+  int angle = shiftExecutor.getServoAngle();
+  if (angle == appliedShiftAngle) return;
+  appliedShiftAngle = angle;
+  if (angle != SERVO_DETACHED) {
+    moveServo(angle);
+  } else if (servoAttached) {
+    gearServo.detach();
+    servoAttached = false;
+  }
+}
+
+void readCAN() {
+  CanFrame frame;
+  while (canRing.pop(frame)) {
+    if (!decodeCanFrame(frame, canState)) continue;
+    shiftExecutor.onGear(canState.gear, millis());
+    applyShiftServo();
+    printTelemetry();
+  }
+}
 
-  uint8_t gear = data[3] & 0x0F;
-  uint16_t rpm = (data[1] << 8) | data[2];
-  float temp = ((data[6] << 8) | data[7]) / 10.0;
+void printShiftReport() {
+  ShiftReport report;
+  if (!shiftExecutor.takeReport(report)) return;
+  Serial.print("X:"); Serial.print(report.fromGear);
+  Serial.print(","); Serial.print(report.toGear);
+  Serial.print(","); Serial.print(report.result);
+  Serial.print(","); Serial.println(report.durationMs);
+}
 
-  Serial.print("G:"); Serial.print(gear);
-  Serial.print(",R:"); Serial.print(rpm);
-  Serial.print(",T:"); Serial.print(temp);
-  Serial.print(",Th:"); Serial.print(throttle);
-  Serial.print(",L:"); Serial.print(engineLoad);
-  Serial.print(",A:"); Serial.print(ambiTemp);
-  Serial.print(",V:"); Serial.println(batteryVoltage);
+void printStatus() {
+  noInterrupts();
+  uint32_t received = canRing.received;
+  uint32_t dropped = canRing.dropped;
+  interrupts();
+  Serial.print("S:"); Serial.print(received);
+  Serial.print(","); Serial.print(dropped);
+  Serial.print(","); Serial.println(canState.ignored);
 }
 
-void readCAN() {
-  if (!CAN.parsePacket()) return;
-  uint8_t buf[8], i = 0;
-  while (CAN.available() && i < 8) buf[i++] = CAN.read();
+void handleGearCommand(const char* args) {
+  long pos;
+  if (shiftExecutor.isBusy()) return;
+  if (!parseCommandInt(args, pos) || pos < 0 || pos > 180) return;
+  moveServo(pos);
+}
 
-  if (CAN.packetId() == 0x7E8) handleOBDResponse(buf);
-  else if (CAN.packetId() == 0x540) handleCustom540(buf);
+// X:<from>,<to> shifts one step, answered by X:<from>,<to>,<result>,<ms>
+void handleShiftCommand(const char* args) {
+  long gears[2];
+  if (!parseCommandInts(args, gears, 2)) return;
+  if (gears[0] < 0 || gears[0] > SHIFT_GEAR_MAX || gears[1] < 0 || gears[1] > SHIFT_GEAR_MAX) return;
+  shiftExecutor.start(gears[0], gears[1], canState.gear, millis());
+  applyShiftServo();
 }
 
+const SerialCommand serialCommands[] = {
+  { "G:", handleGearCommand },
+  { "X:", handleShiftCommand },
+};
+SerialCommandParser commandParser(serialCommands, sizeof(serialCommands) / sizeof(serialCommands[0]));
+
 void setup() {
   Serial.begin(115200);
   while (!Serial);
   analogReference(INTERNAL);
   if (!CAN.begin(1E6)) while (1);
+  CAN.filter(CAN_FILTER_ID, CAN_FILTER_MASK);
+  CAN.onReceive(onCANReceive);
 }
 
 void loop() {
-  float voltage = analogRead(batteryPin) * (2.56 / 1023.0);
-  batteryVoltage = voltage * ((R1 + R2) / R2);
+  // A conversion takes ~100 us and the voltage barely moves, sample at 100 Hz
+  if (millis() - lastBatteryTime >= BATTERY_INTERVAL_MS) {
+    lastBatteryTime = millis();
+    float voltage = analogRead(batteryPin) * (2.56 / 1023.0);
+    batteryVoltage = voltage * ((R1 + R2) / R2);
+  }
   if (millis() - lastRequestTime >= 5) {
     lastRequestTime = millis();
     sendPIDRequest();
   }
   readCAN();
 
-  if (Serial.available()) {
-    String input = Serial.readStringUntil('\n');
-    input.trim();
-    if (input.startsWith("G:")) {
-      int pos = input.substring(2).toInt();
-      if (pos >= 0 && pos <= 180) {
-        if (!servoAttached) {
-          gearServo.attach(gearServoPin);
-          servoAttached = true;
-        }
-        gearServo.write(pos);
-        gearServoPos = pos;
-        lastServoCommandTime = millis();
-      }
-    }
+  if (millis() - lastStatusTime >= STATUS_INTERVAL_MS) {
+    lastStatusTime = millis();
+    printStatus();
   }
 
-  if (servoAttached && (millis() - lastServoCommandTime > 1000)) {
+  while (Serial.available()) {
+    commandParser.feed(Serial.read());
+  }
+
+  shiftExecutor.update(millis());
+  applyShiftServo();
+  printShiftReport();
+
+  if (servoAttached && !shiftExecutor.isBusy() && (millis() - lastServoCommandTime > 1000)) {
     gearServo.detach();
     servoAttached = false;
   }
-  delay(1);
 }
@@ -0,0 +1,166 @@
+#include "AllocCheck.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifndef CLUSTER_ALLOC_CHECK
+#define CLUSTER_ALLOC_CHECK 0
+#endif
+
+namespace {
+
+std::atomic<bool> armed{false};
+std::atomic<uint64_t> count{0};
+std::atomic<uint64_t> mallocCount{0};
+
+}
+
+// glibc exports its allocator under __libc_* as well, which lets this file
+// replace malloc without dlsym (that allocates itself)
+#if CLUSTER_ALLOC_CHECK && defined(__GLIBC__)
+#define ALLOC_CHECK_MALLOC 1
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+}
+#else
+#define ALLOC_CHECK_MALLOC 0
+#endif
+
+bool AllocCheck::isEnabled() {
+    return CLUSTER_ALLOC_CHECK;
+}
+
+bool AllocCheck::countsMalloc() {
+    return ALLOC_CHECK_MALLOC;
+}
+
+void AllocCheck::arm() {
+    count = 0;
+    mallocCount = 0;
+    armed = true;
+}
+
+void AllocCheck::disarm() {
+    armed = false;
+}
+
+uint64_t AllocCheck::allocations() {
+    return count;
+}
+
+uint64_t AllocCheck::mallocs() {
+    return mallocCount;
+}
+
+#if CLUSTER_ALLOC_CHECK
+
+static void* countedAlloc(size_t size) {
+    if (armed.load(std::memory_order_relaxed)) {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+#if ALLOC_CHECK_MALLOC
+    return __libc_malloc(size ? size : 1);
+#else
+    return malloc(size ? size : 1);
+#endif
+}
+
+static void* countedAlignedAlloc(size_t size, std::align_val_t alignment) {
+    if (armed.load(std::memory_order_relaxed)) {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+    size_t align = (size_t)alignment;
+    return aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void* operator new(size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* p = countedAlignedAlloc(size, alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    void* p = countedAlignedAlloc(size, alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+#if ALLOC_CHECK_MALLOC
+
+static void countMalloc() {
+    if (armed.load(std::memory_order_relaxed)) {
+        mallocCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+extern "C" void* malloc(size_t size) {
+    countMalloc();
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    countMalloc();
+    return __libc_calloc(count, size);
+}
+
+// realloc(p, 0) frees
+extern "C" void* realloc(void* p, size_t size) {
+    if (!p || size) countMalloc();
+    return __libc_realloc(p, size);
+}
+
+// Whether glibc's own strdup reaches the malloc above depends on how glibc
+// was built, these count either way
+static char* countedCopy(const char* s, size_t length) {
+    countMalloc();
+    char* copy = (char*)__libc_malloc(length + 1);
+    if (copy) {
+        memcpy(copy, s, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+extern "C" char* strdup(const char* s) {
+    return countedCopy(s, strlen(s));
+}
+
+extern "C" char* strndup(const char* s, size_t size) {
+    return countedCopy(s, strnlen(s, size));
+}
+
+#endif
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { free(p); }
+
+#endif
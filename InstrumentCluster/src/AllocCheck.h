@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts heap allocations while armed: operator new in allocations(), and
+// with glibc also malloc, calloc, realloc, strdup and strndup from any
+// library in mallocs(). Allocations glibc makes internally (thread stacks,
+// stdio buffers and the like) bypass these symbols and are not counted.
+// The hooks only exist in builds configured with -DCLUSTER_ALLOC_CHECK=ON,
+// elsewhere isEnabled() is false and the counters stay at zero.
+namespace AllocCheck {
+    bool isEnabled();
+    bool countsMalloc();
+    void arm();
+    void disarm();
+    uint64_t allocations();
+    uint64_t mallocs();
+}
@@ -0,0 +1,66 @@
+#include "Animation.h"
+#include <cmath>
+
+void DampedValue::update(float target, float dt) {
+    if (dt <= 0.0f) {
+        lastTarget = target;
+        return;
+    }
+    // Solve relative to the steady-state lag behind a target moving at a
+    // constant rate, which makes piecewise linear targets exact as well
+    float targetRate = (target - lastTarget) / dt;
+    float lag = 2.0f * targetRate / omega;
+    float offset = current - lastTarget + lag;
+    float offsetRate = velocity - targetRate;
+    float decay = expf(-omega * dt);
+    float drift = (offsetRate + omega * offset) * dt;
+    current = target - lag + (offset + drift) * decay;
+    velocity = targetRate + (offsetRate - omega * drift) * decay;
+    lastTarget = target;
+}
+
+void DampedValue::reset(float value) {
+    current = value;
+    velocity = 0.0f;
+    lastTarget = value;
+}
+
+bool DampedValue::settled(float target, float epsilon) const {
+    return fabsf(current - target) < epsilon && fabsf(velocity) < epsilon;
+}
+
+void SampleTrack::push(uint64_t timeUs, float value) {
+    if (hasLast && timeUs <= lastTime) {
+        lastValue = value;
+        return;
+    }
+    prevTime = lastTime;
+    prevValue = lastValue;
+    hasPrev = hasLast;
+    lastTime = timeUs;
+    lastValue = value;
+    hasLast = true;
+}
+
+float SampleTrack::sample(uint64_t timeUs) const {
+    if (!hasPrev) {
+        return lastValue;
+    }
+    float slope = (lastValue - prevValue) / (float)(lastTime - prevTime);
+    if (timeUs <= prevTime) {
+        return prevValue;
+    }
+    if (timeUs <= lastTime) {
+        return prevValue + slope * (float)(timeUs - prevTime);
+    }
+    uint64_t ahead = timeUs - lastTime;
+    if (ahead > maxExtrapolationUs) {
+        ahead = maxExtrapolationUs;
+    }
+    return lastValue + slope * (float)ahead;
+}
+
+float triangleWave(uint64_t elapsedUs, uint64_t periodUs) {
+    float phase = (float)(elapsedUs % periodUs) / (float)periodUs;
+    return phase < 0.5f ? phase * 2.0f : 2.0f - phase * 2.0f;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+const float NEEDLE_OMEGA = 40.0f;
+const float BAR_OMEGA = 30.0f;
+const uint64_t MAX_SAMPLE_EXTRAPOLATION_US = 60000;
+const float MAX_ANIMATION_STEP = 0.1f;
+
+// Critically damped second order filter. Stepping uses the exact solution
+// for a target moving linearly during the step, so the trajectory only depends
+// on elapsed time and not on how many frames it was split into.
+class DampedValue {
+public:
+    explicit DampedValue(float omega) : omega(omega) {}
+    void update(float target, float dt);
+    void reset(float value);
+    float value() const { return current; }
+    bool settled(float target, float epsilon) const;
+private:
+    float omega;
+    float current = 0.0f;
+    float velocity = 0.0f;
+    float lastTarget = 0.0f;
+};
+
+// Last two timestamped telemetry samples of one channel. Values between the
+// samples are interpolated, past the newest sample the trend is extrapolated
+// for at most maxExtrapolationUs and then held.
+class SampleTrack {
+public:
+    explicit SampleTrack(uint64_t maxExtrapolationUs) : maxExtrapolationUs(maxExtrapolationUs) {}
+    void push(uint64_t timeUs, float value);
+    float sample(uint64_t timeUs) const;
+private:
+    uint64_t maxExtrapolationUs;
+    uint64_t prevTime = 0;
+    uint64_t lastTime = 0;
+    float prevValue = 0.0f;
+    float lastValue = 0.0f;
+    bool hasPrev = false;
+    bool hasLast = false;
+};
+
+// Symmetric triangle wave in [0, 1] starting at 0, one cycle per period.
+float triangleWave(uint64_t elapsedUs, uint64_t periodUs);
@@ -0,0 +1,290 @@
+#include "ArcRasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+typedef __m128 F4;
+typedef __m128i U4;
+
+static inline F4 f4Set(float v) { return _mm_set1_ps(v); }
+static inline F4 f4Ramp() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+static inline F4 f4Add(F4 a, F4 b) { return _mm_add_ps(a, b); }
+static inline F4 f4Sub(F4 a, F4 b) { return _mm_sub_ps(a, b); }
+static inline F4 f4Mul(F4 a, F4 b) { return _mm_mul_ps(a, b); }
+static inline F4 f4Min(F4 a, F4 b) { return _mm_min_ps(a, b); }
+static inline F4 f4Max(F4 a, F4 b) { return _mm_max_ps(a, b); }
+static inline F4 f4Sqrt(F4 a) { return _mm_sqrt_ps(a); }
+static inline U4 f4GreaterZero(F4 a) { return _mm_castps_si128(_mm_cmpgt_ps(a, _mm_setzero_ps())); }
+static inline U4 f4ToU4(F4 a) { return _mm_cvttps_epi32(a); }
+static inline U4 u4Shl(U4 a, int n) { return _mm_slli_epi32(a, n); }
+static inline U4 u4Or(U4 a, U4 b) { return _mm_or_si128(a, b); }
+static inline U4 u4Select(U4 mask, U4 a, U4 b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+static inline U4 u4Load(const Uint32* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+static inline void u4Store(Uint32* p, U4 v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+
+typedef float32x4_t F4;
+typedef uint32x4_t U4;
+
+static inline F4 f4Set(float v) { return vdupq_n_f32(v); }
+static inline F4 f4Ramp() { const float r[4] = {0.0f, 1.0f, 2.0f, 3.0f}; return vld1q_f32(r); }
+static inline F4 f4Add(F4 a, F4 b) { return vaddq_f32(a, b); }
+static inline F4 f4Sub(F4 a, F4 b) { return vsubq_f32(a, b); }
+static inline F4 f4Mul(F4 a, F4 b) { return vmulq_f32(a, b); }
+static inline F4 f4Min(F4 a, F4 b) { return vminq_f32(a, b); }
+static inline F4 f4Max(F4 a, F4 b) { return vmaxq_f32(a, b); }
+static inline F4 f4Sqrt(F4 a) { return vsqrtq_f32(a); }
+static inline U4 f4GreaterZero(F4 a) { return vcgtq_f32(a, vdupq_n_f32(0.0f)); }
+static inline U4 f4ToU4(F4 a) { return vcvtq_u32_f32(a); }
+#define u4Shl(a, n) vshlq_n_u32((a), (n))
+static inline U4 u4Or(U4 a, U4 b) { return vorrq_u32(a, b); }
+static inline U4 u4Select(U4 mask, U4 a, U4 b) { return vbslq_u32(mask, a, b); }
+static inline U4 u4Load(const Uint32* p) { return vld1q_u32(p); }
+static inline void u4Store(Uint32* p, U4 v) { vst1q_u32(p, v); }
+
+#else
+
+struct F4 { float v[4]; };
+struct U4 { Uint32 v[4]; };
+
+#define LANES(expr) { F4 r; for (int i = 0; i < 4; i++) r.v[i] = (expr); return r; }
+#define ULANES(expr) { U4 r; for (int i = 0; i < 4; i++) r.v[i] = (expr); return r; }
+static inline F4 f4Set(float v) LANES(v)
+static inline F4 f4Ramp() LANES((float)i)
+static inline F4 f4Add(F4 a, F4 b) LANES(a.v[i] + b.v[i])
+static inline F4 f4Sub(F4 a, F4 b) LANES(a.v[i] - b.v[i])
+static inline F4 f4Mul(F4 a, F4 b) LANES(a.v[i] * b.v[i])
+static inline F4 f4Min(F4 a, F4 b) LANES(std::min(a.v[i], b.v[i]))
+static inline F4 f4Max(F4 a, F4 b) LANES(std::max(a.v[i], b.v[i]))
+static inline F4 f4Sqrt(F4 a) LANES(sqrtf(a.v[i]))
+static inline U4 f4GreaterZero(F4 a) ULANES(a.v[i] > 0.0f ? 0xFFFFFFFFu : 0u)
+static inline U4 f4ToU4(F4 a) ULANES((Uint32)a.v[i])
+static inline U4 u4Shl(U4 a, int n) ULANES(a.v[i] << n)
+static inline U4 u4Or(U4 a, U4 b) ULANES(a.v[i] | b.v[i])
+static inline U4 u4Select(U4 mask, U4 a, U4 b) ULANES((mask.v[i] & a.v[i]) | (~mask.v[i] & b.v[i]))
+static inline U4 u4Load(const Uint32* p) ULANES(p[i])
+static inline void u4Store(Uint32* p, U4 v) { for (int i = 0; i < 4; i++) p[i] = v.v[i]; }
+#undef LANES
+#undef ULANES
+
+#endif
+
+// Room for every arc of a frame, so recording one never allocates
+const size_t MAX_ARCS_PER_FRAME = 8;
+
+enum ArcParam {
+    P_LO_COS, P_LO_SIN, P_HI_COS, P_HI_SIN, P_WIDE, P_FULL,
+    P_INNER, P_OUTER, P_INV_SPAN,
+    P_R, P_G, P_B, P_A, P_DR, P_DG, P_DB, P_DA,
+    P_COUNT
+};
+
+ArcRasterizer::ArcRasterizer() : textures(nullptr), texture(nullptr), width(0), height(0), pitch(0), centerX(0), centerY(0),
+    dirty{0, 0, 0, 0}, prevDirty{0, 0, 0, 0}, swapRedBlue(false), premultiplied(false) {}
+
+void ArcRasterizer::release() {
+    if (texture) {
+        textures->release(texture);
+        texture = nullptr;
+    }
+}
+
+bool ArcRasterizer::init(TextureManager& textures, int width, int height, int centerX, int centerY) {
+    this->textures = &textures;
+    this->width = width;
+    this->height = height;
+    this->centerX = centerX;
+    this->centerY = centerY;
+    pitch = (width + 3) & ~3;
+    pixels.assign((size_t)pitch * height, 0);
+    arcs.reserve(MAX_ARCS_PER_FRAME);
+    drawnArcs.reserve(MAX_ARCS_PER_FRAME);
+    drawnArcs.clear();
+    prevDirty = {0, 0, 0, 0};
+
+    // The rows are packed as ARGB or ABGR, anything else is left to SDL
+    Uint32 format = textures.getNativeFormat();
+    if (format != SDL_PIXELFORMAT_ABGR8888) {
+        format = SDL_PIXELFORMAT_ARGB8888;
+    }
+    swapRedBlue = format == SDL_PIXELFORMAT_ABGR8888;
+    premultiplied = textures.isPremultiplied();
+    texture = textures.acquire(TEXTURE_STREAMING, format, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (!texture) {
+        return false;
+    }
+    SDL_SetTextureBlendMode(texture, textures.getAlphaBlendMode());
+    SDL_UpdateTexture(texture, nullptr, pixels.data(), pitch * 4);
+    return true;
+}
+
+static bool sameColor(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+bool ArcRasterizer::Arc::operator==(const Arc& other) const {
+    return startAngle == other.startAngle && endAngle == other.endAngle && outerRad == other.outerRad
+        && innerRad == other.innerRad && sameColor(innerColor, other.innerColor) && sameColor(outerColor, other.outerColor);
+}
+
+void ArcRasterizer::begin() {
+    arcs.clear();
+}
+
+SDL_Rect ArcRasterizer::sectorBounds(float lo, float hi, int outerRad, int innerRad) const {
+    float minX = 1e9f, minY = 1e9f, maxX = -1e9f, maxY = -1e9f;
+    auto addPoint = [&](float angle, float r) {
+        float angleRad = angle * (float)M_PI / 180.0f;
+        float x = (float)centerX - r * cosf(angleRad);
+        float y = (float)centerY + r * sinf(angleRad);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    };
+    for (float r : {(float)innerRad, (float)outerRad}) {
+        addPoint(lo, r);
+        addPoint(hi, r);
+    }
+    for (int k = (int)ceilf(lo / 90.0f); k * 90.0f <= hi; ++k) {
+        addPoint(k * 90.0f, (float)outerRad);
+    }
+
+    int x0 = std::max(0, (int)floorf(minX) - 2) & ~3;
+    int y0 = std::max(0, (int)floorf(minY) - 2);
+    int x1 = std::min(pitch, ((int)ceilf(maxX) + 2 + 3) & ~3);
+    int y1 = std::min(height, (int)ceilf(maxY) + 2);
+    if (x1 <= x0 || y1 <= y0) {
+        return {0, 0, 0, 0};
+    }
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+void ArcRasterizer::fillArc(float startAngle, float endAngle, int outerRad, int innerRad, SDL_Color innerColor, SDL_Color outerColor) {
+    arcs.push_back({startAngle, endAngle, outerRad, innerRad, innerColor, outerColor});
+}
+
+void ArcRasterizer::rasterize(const Arc& arc) {
+    float lo = std::min(arc.startAngle, arc.endAngle);
+    float hi = std::max(arc.startAngle, arc.endAngle);
+    int outerRad = arc.outerRad;
+    int innerRad = arc.innerRad;
+    SDL_Color innerColor = arc.innerColor;
+    SDL_Color outerColor = arc.outerColor;
+    float span = hi - lo;
+    bool full = span >= 360.0f;
+    if (full) {
+        lo = 0.0f;
+        hi = 360.0f;
+    }
+
+    SDL_Rect bounds = sectorBounds(lo, hi, outerRad, innerRad);
+    if (bounds.w <= 0) {
+        return;
+    }
+
+    float loRad = lo * (float)M_PI / 180.0f;
+    float hiRad = hi * (float)M_PI / 180.0f;
+    float params[P_COUNT];
+    params[P_LO_COS] = cosf(loRad);
+    params[P_LO_SIN] = sinf(loRad);
+    params[P_HI_COS] = cosf(hiRad);
+    params[P_HI_SIN] = sinf(hiRad);
+    params[P_WIDE] = span > 180.0f ? 1.0f : 0.0f;
+    params[P_FULL] = full ? 1.0f : 0.0f;
+    params[P_INNER] = (float)innerRad;
+    params[P_OUTER] = (float)outerRad;
+    params[P_INV_SPAN] = outerRad > innerRad ? 1.0f / (float)(outerRad - innerRad) : 0.0f;
+    params[P_R] = innerColor.r;
+    params[P_G] = innerColor.g;
+    params[P_B] = innerColor.b;
+    params[P_A] = innerColor.a;
+    params[P_DR] = (float)outerColor.r - innerColor.r;
+    params[P_DG] = (float)outerColor.g - innerColor.g;
+    params[P_DB] = (float)outerColor.b - innerColor.b;
+    params[P_DA] = (float)outerColor.a - innerColor.a;
+
+    for (int y = bounds.y; y < bounds.y + bounds.h; ++y) {
+        fillRow(y, bounds.x, bounds.x + bounds.w, params);
+    }
+
+    SDL_Rect visible = {bounds.x, bounds.y, std::min(bounds.w, width - bounds.x), bounds.h};
+    SDL_UnionRect(&dirty, &visible, &dirty);
+}
+
+void ArcRasterizer::fillRow(int y, int x0, int x1, const float* params) {
+    const F4 zero = f4Set(0.0f);
+    const F4 one = f4Set(1.0f);
+    const F4 half = f4Set(0.5f);
+    const F4 inv255 = f4Set(1.0f / 255.0f);
+    const F4 ramp = f4Ramp();
+    const F4 inner = f4Set(params[P_INNER]);
+    const F4 outer = f4Set(params[P_OUTER]);
+    const F4 invSpan = f4Set(params[P_INV_SPAN]);
+    const F4 loCos = f4Set(params[P_LO_COS]), loSin = f4Set(params[P_LO_SIN]);
+    const F4 hiCos = f4Set(params[P_HI_COS]), hiSin = f4Set(params[P_HI_SIN]);
+    const F4 r0 = f4Set(params[P_R]), g0 = f4Set(params[P_G]), b0 = f4Set(params[P_B]), a0 = f4Set(params[P_A]);
+    const F4 dr = f4Set(params[P_DR]), dg = f4Set(params[P_DG]), db = f4Set(params[P_DB]), da = f4Set(params[P_DA]);
+    const bool wide = params[P_WIDE] != 0.0f;
+    const bool full = params[P_FULL] != 0.0f;
+
+    // Local frame matching generateArcPoints: x = cx - r*cos(a), y = cy + r*sin(a)
+    const F4 v = f4Set((float)y + 0.5f - (float)centerY);
+    const F4 vv = f4Mul(v, v);
+    const F4 loV = f4Mul(loCos, v);
+    const F4 hiV = f4Mul(hiCos, v);
+    Uint32* row = &pixels[(size_t)y * pitch];
+
+    for (int x = x0; x < x1; x += 4) {
+        F4 u = f4Sub(f4Set((float)centerX - (float)x - 0.5f), ramp);
+        F4 r = f4Sqrt(f4Add(f4Mul(u, u), vv));
+        F4 d = f4Min(f4Sub(r, inner), f4Sub(outer, r));
+        if (!full) {
+            F4 dLo = f4Sub(loV, f4Mul(loSin, u));
+            F4 dHi = f4Sub(f4Mul(hiSin, u), hiV);
+            d = f4Min(d, wide ? f4Max(dLo, dHi) : f4Min(dLo, dHi));
+        }
+        F4 coverage = f4Min(one, f4Max(zero, f4Add(d, half)));
+        U4 mask = f4GreaterZero(coverage);
+
+        F4 t = f4Min(one, f4Max(zero, f4Mul(f4Sub(r, inner), invSpan)));
+        F4 alphaF = f4Mul(f4Add(a0, f4Mul(da, t)), coverage);
+        F4 colorScale = premultiplied ? f4Mul(alphaF, inv255) : one;
+        U4 red = f4ToU4(f4Add(f4Mul(f4Add(r0, f4Mul(dr, t)), colorScale), half));
+        U4 green = f4ToU4(f4Add(f4Mul(f4Add(g0, f4Mul(dg, t)), colorScale), half));
+        U4 blue = f4ToU4(f4Add(f4Mul(f4Add(b0, f4Mul(db, t)), colorScale), half));
+        U4 alpha = f4ToU4(f4Add(alphaF, half));
+        U4 high = swapRedBlue ? blue : red;
+        U4 low = swapRedBlue ? red : blue;
+        U4 argb = u4Or(u4Or(u4Shl(alpha, 24), u4Shl(high, 16)), u4Or(u4Shl(green, 8), low));
+
+        u4Store(row + x, u4Select(mask, argb, u4Load(row + x)));
+    }
+}
+
+void ArcRasterizer::draw(SDL_Renderer* renderer) {
+    if (!(arcs == drawnArcs)) {
+        for (int y = prevDirty.y; y < prevDirty.y + prevDirty.h; ++y) {
+            memset(&pixels[(size_t)y * pitch + prevDirty.x], 0, prevDirty.w * sizeof(Uint32));
+        }
+        dirty = {0, 0, 0, 0};
+        for (const Arc& arc : arcs) {
+            rasterize(arc);
+        }
+        SDL_Rect upload;
+        SDL_UnionRect(&prevDirty, &dirty, &upload);
+        if (upload.w > 0 && upload.h > 0) {
+            SDL_UpdateTexture(texture, &upload, &pixels[(size_t)upload.y * pitch + upload.x], pitch * 4);
+        }
+        prevDirty = dirty;
+        drawnArcs = arcs;
+    }
+    if (prevDirty.w > 0 && prevDirty.h > 0) {
+        SDL_RenderCopy(renderer, texture, &prevDirty, &prevDirty);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include "TextureManager.h"
+
+// Software rasterizer for annular sectors around a fixed center. Coverage is
+// computed per pixel (4 at a time with SSE2/NEON) from the signed distance to
+// the inner/outer radius and the two edge rays, giving analytic anti-aliasing.
+// All arcs of a frame are accumulated in one CPU buffer which is uploaded to a
+// streaming texture once in draw(). Pixels are written in the texture
+// manager's native layout and alpha mode, so the upload is a plain copy.
+// fillArc() only records the arc, a frame with the same arcs as the last one
+// skips rasterizing and uploading and draws the texture as it is.
+class ArcRasterizer {
+public:
+    ArcRasterizer();
+    bool init(TextureManager& textures, int width, int height, int centerX, int centerY);
+    bool isInitialized() const { return texture != nullptr; }
+    void begin();
+    void fillArc(float startAngle, float endAngle, int outerRad, int innerRad, SDL_Color innerColor, SDL_Color outerColor);
+    void draw(SDL_Renderer* renderer);
+    void release();
+private:
+    struct Arc {
+        float startAngle, endAngle;
+        int outerRad, innerRad;
+        SDL_Color innerColor, outerColor;
+        bool operator==(const Arc& other) const;
+    };
+    void rasterize(const Arc& arc);
+    void fillRow(int y, int x0, int x1, const float* params);
+    SDL_Rect sectorBounds(float lo, float hi, int outerRad, int innerRad) const;
+    TextureManager* textures;
+    SDL_Texture* texture;
+    std::vector<Uint32> pixels;
+    std::vector<Arc> arcs;
+    std::vector<Arc> drawnArcs;
+    int width, height, pitch;
+    int centerX, centerY;
+    SDL_Rect dirty;
+    SDL_Rect prevDirty;
+    bool swapRedBlue;
+    bool premultiplied;
+};
@@ -1,30 +1,54 @@
 #include "Arduino.h"
+#include "Clock.h"
+#include "Trace.h"
+#include "Telemetry.h"
+#include "FixedString.h"
 #include <filesystem>
-#include <regex>
 #include <iostream>
 #include <fcntl.h>
 #include <unistd.h>
 #include <termios.h>
 #include <sys/ioctl.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 #include <errno.h>
 #include <cstring>
+#include <cstdio>
 
-Arduino::Arduino() :
-    isRunning(false) {}
+Arduino::Arduino(const std::string& busName) :
+    isRunning(false), telemetryBus(busName) {
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
 
 Arduino::~Arduino() {
     stop();
     if (serialThread.joinable()){
         serialThread.join();
     }
+    if (hotplugFd >= 0) {
+        close(hotplugFd);
+    }
+    if (wakeFd >= 0) {
+        close(wakeFd);
+    }
 }
 
 void Arduino::start() {
     if (isRunning) return;
 
     isRunning = true;
+    hotplugFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (hotplugFd < 0) {
+        std::cerr << "Arduino: inotify unavailable (" << strerror(errno) << "), rescanning every "
+                  << HOTPLUG_RESCAN_MS << " ms" << std::endl;
+    } else {
+        addHotplugWatches();
+    }
     serialThread = std::thread([this]
     {
+        TRACE_THREAD_NAME("serial");
+        Scheduling::applyToCurrentThread(threadProfile, "serial thread");
         while (isRunning) {
             try {
                 std::string chosenPort = findArduinoPort();
@@ -58,12 +82,14 @@ void Arduino::start() {
                 if (tcsetattr(fd, TCSANOW, &tty) != 0) {
                     throw std::runtime_error("Failed to set serial attributes: " + std::string(strerror(errno)));
                 }
+                linkHealth.onConnect();
                 processSerial();
             } catch (const std::exception& e) {
-                std::cerr << "Arduino: " << e.what() << " - retrying in 1s" << std::endl;
-                if (fd >= 0) { close(fd); fd = -1; }
-                sleep(1);
+                std::cerr << "Arduino: " << e.what() << " - waiting for device" << std::endl;
             }
+            if (fd >= 0) { close(fd); fd = -1; }
+            linkHealth.onDisconnect();
+            if (isRunning) waitForHotplug();
         }
     });
 }
@@ -72,15 +98,96 @@ void Arduino::stop() {
     isRunning = false;
 }
 
-void Arduino::setGearAngle(int angle) {
-    gearAngle = angle;
+void Arduino::requestShift(int fromGear, int toGear) {
+    pendingShift = fromGear << 4 | toGear;
+}
+
+bool Arduino::takeShiftReport(ShiftReport& report) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    if (!shiftReportPending) return false;
+    report = shiftReport;
+    shiftReportPending = false;
+    return true;
 }
 
 VehicleData Arduino::getData() const {
-    return data;
+    std::lock_guard<std::mutex> lock(dataMutex);
+    VehicleData snapshot = data;
+    snapshot.stale = linkHealth.isStale(monotonicMicros());
+    return snapshot;
+}
+
+LinkHealthSnapshot Arduino::getLinkHealth() const {
+    return linkHealth.snapshot(monotonicMicros());
+}
+
+void Arduino::wake() {
+    uint64_t one = 1;
+    if (wakeFd >= 0) write(wakeFd, &one, sizeof(one));
+}
+
+void Arduino::takeWakeup() {
+    uint64_t count;
+    if (wakeFd >= 0) read(wakeFd, &count, sizeof(count));
+}
+
+// Watches the directory the device node or its by-id link shows up in. A
+// fixed port is watched in its own directory. /dev/serial/by-id only exists
+// once udev saw a serial device, until then it is retried on every wait.
+void Arduino::addHotplugWatches() {
+    const uint32_t mask = IN_CREATE | IN_ATTRIB | IN_MOVED_TO;
+    // -1 is untried, -2 failed before and was already logged
+    if (devWatch < 0) {
+        std::string dir = portPath.empty() ? "/dev" : std::filesystem::path(portPath).parent_path().string();
+        bool firstTry = devWatch == -1;
+        devWatch = inotify_add_watch(hotplugFd, dir.c_str(), mask);
+        if (devWatch < 0) {
+            if (firstTry) {
+                std::cerr << "Arduino: cannot watch " << dir << " (" << strerror(errno) << "), rescanning every "
+                          << HOTPLUG_RESCAN_MS << " ms" << std::endl;
+            }
+            devWatch = -2;
+        }
+    }
+#if not IS_RASPI
+    if (portPath.empty() && byIdWatch < 0) {
+        bool firstTry = byIdWatch == -1;
+        byIdWatch = inotify_add_watch(hotplugFd, "/dev/serial/by-id", mask);
+        if (byIdWatch < 0) {
+            if (firstTry) {
+                std::cerr << "Arduino: /dev/serial/by-id does not exist yet, rescanning every "
+                          << HOTPLUG_RESCAN_MS << " ms until it does" << std::endl;
+            }
+            byIdWatch = -2;
+        }
+    }
+#endif
+}
+
+// Blocks until something is created or changes in a watched directory (e.g.
+// the USB serial node showing up or udev fixing its permissions), with a
+// periodic rescan as fallback when inotify is unavailable or an event was missed.
+void Arduino::waitForHotplug() {
+    if (hotplugFd < 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(HOTPLUG_RESCAN_MS));
+        return;
+    }
+    addHotplugWatches();
+
+    struct pollfd pfd = {hotplugFd, POLLIN, 0};
+    if (poll(&pfd, 1, HOTPLUG_RESCAN_MS) > 0) {
+        char events[4096];
+        while (read(hotplugFd, events, sizeof(events)) > 0) {}
+    }
 }
 
 std::string Arduino::findArduinoPort() {
+    if (!portPath.empty()) {
+        if (!std::filesystem::exists(portPath)) {
+            throw std::runtime_error("No Arduino at " + portPath);
+        }
+        return portPath;
+    }
 #if IS_RASPI
     for (const auto& prefix : {"/dev/ttyUSB", "/dev/ttyACM"}) {
         for (int i = 0; i < 4; i++) {
@@ -110,37 +217,85 @@ std::string Arduino::findArduinoPort() {
 }
 
 void Arduino::processSerial() {
-    std::string buffer;
-    std::regex re(R"(G:(\d+),R:(\d+),T:([\d\.]+),Th:([\d\.]+),L:([\d\.]+),A:([\d\.]+),V:([\d\.]+))");
-    char c;
+    FixedString<SERIAL_LINE_MAX> buffer;
+    FixedString<16> command;
+    char chunk[256];
     while (isRunning) {
         try {
-            ssize_t n = read(fd, &c, 1);
-            if (n == 1) {
-                if (c == '\n') {
-                    std::smatch match;
-                    if (std::regex_search(buffer, match, re) && match.size() == 8) {
-                        data.currentGear = std::stoi(match[1]);
-                        data.engineRpm = std::stoi(match[2]);
-                        data.coolantTemp = std::stof(match[3]);
-                        data.throttle = std::stof(match[4]);
-                        data.engineLoad = std::stof(match[5]);
-                        data.ambientTemp = std::stof(match[6]);
-                        data.voltage = std::stof(match[7]);
-                    }
-                    buffer.clear();
-                } else {
-                    buffer += c;
-                }
+            int shift = pendingShift.exchange(-1);
+            if (shift >= 0) {
+                command.clear();
+                command.append("X:").appendInt(shift >> 4).append(',').appendInt(shift & 0x0F).append('\n');
+                write(fd, command.c_str(), command.size());
+            }
 
-                if (gearAngle != GEAR_NONE && gearAngle >= SHIFT_UP_ANGLE && gearAngle <= SHIFT_DOWN_ANGLE) {
-                    std::string command = "G:" + std::to_string(gearAngle) + "\n";
-                    write(fd, command.c_str(), command.size());
-                    gearAngle = GEAR_NONE;
-                }
+            struct pollfd pfd = {fd, POLLIN, 0};
+            int ready = poll(&pfd, 1, SERIAL_POLL_MS);
+            if (ready < 0 && errno != EINTR) {
+                throw std::runtime_error("Serial poll error: " + std::string(strerror(errno)));
+            }
+            if (ready <= 0) continue;
+            if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                throw std::runtime_error("Serial port disconnected");
+            }
+
+            ssize_t n;
+            {
+                TRACE_ZONE("serial.read");
+                n = read(fd, chunk, sizeof(chunk));
+            }
+            if (n == 0) {
+                throw std::runtime_error("Serial port disconnected");
             } else if (n < 0) {
+                if (errno == EAGAIN || errno == EINTR) continue;
                 throw std::runtime_error("Serial read error: " + std::string(strerror(errno)));
             }
+            linkHealth.onBytes(n);
+
+            for (ssize_t i = 0; i < n; ++i) {
+                char c = chunk[i];
+                if (c != '\n') {
+                    buffer.append(c);
+                    continue;
+                }
+                TRACE_ZONE("serial.parse");
+                unsigned long canReceived, canDropped, canIgnored;
+                if (sscanf(buffer.c_str(), "S:%lu,%lu,%lu", &canReceived, &canDropped, &canIgnored) == 3) {
+                    linkHealth.onFirmwareStatus(canReceived, canDropped, canIgnored);
+                    buffer.clear();
+                    continue;
+                }
+                ShiftReport report;
+                if (sscanf(buffer.c_str(), "X:%d,%d,%d,%lu", &report.fromGear, &report.toGear, &report.result, &report.durationMs) == 4) {
+                    std::lock_guard<std::mutex> lock(dataMutex);
+                    shiftReport = report;
+                    shiftReportPending = true;
+                    buffer.clear();
+                    wake();
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(dataMutex);
+                if (!buffer.isTruncated() && parseTelemetryLine(buffer.c_str(), buffer.size(), data)) {
+                    uint64_t now = monotonicMicros();
+                    data.sampleTimeUs = now;
+                    if (uint64_t latencyUs = displayLatencyUs) {
+                        shiftPredictor.setDisplayLatency(latencyUs);
+                    }
+                    shiftPredictor.addSample(data.sampleTimeUs, data.engineRpm, data.currentGear);
+                    data.shiftLight = shiftPredictor.isShiftLightOn();
+                    data.overRev = shiftPredictor.isOverRev();
+                    {
+                        TRACE_ZONE("telemetry.publish");
+                        telemetryBus.publish(data);
+                    }
+                    TRACE_COUNTER("rpm", data.engineRpm);
+                    linkHealth.onFrame(now);
+                    wake();
+                } else if (!buffer.empty()) {
+                    linkHealth.onParseError();
+                }
+                buffer.clear();
+            }
         } catch (const std::exception& e) {
             if (isRunning) std::cerr << "Serial error: " << e.what() << std::endl;
             break;
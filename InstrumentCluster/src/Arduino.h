@@ -3,22 +3,72 @@
 #include <string>
 #include <atomic>
 #include <thread>
+#include <mutex>
 #include "VehicleConstants.h"
+#include "ShiftPredictor.h"
+#include "LinkHealth.h"
+#include "TelemetryBus.h"
+#include "Scheduling.h"
+
+const int HOTPLUG_RESCAN_MS = 1000;
+const int SERIAL_POLL_MS = 100;
+const size_t SERIAL_LINE_MAX = 256;
+
+enum ShiftResult {
+    SHIFT_ENGAGED,
+    SHIFT_TIMEOUT,
+    SHIFT_REJECTED
+};
+
+// Answer to requestShift(), timed by the firmware from its own command
+// receipt to the target gear showing up on CAN
+struct ShiftReport {
+    int fromGear;
+    int toGear;
+    int result;
+    unsigned long durationMs;
+};
 
 class Arduino {
 public:
-    Arduino();
+    explicit Arduino(const std::string& busName = TELEMETRY_BUS_NAME);
     ~Arduino();
+    // Use this device (or symlink) instead of scanning for the Arduino
+    void setPort(const std::string& path) { portPath = path; }
+    void setThreadProfile(const ThreadProfile& profile) { threadProfile = profile; }
     void start();
     void stop();
-    void setGearAngle(int angle);
+    // A single step, the firmware rejects anything further
+    void requestShift(int fromGear, int toGear);
+    void setDisplayLatency(uint64_t latencyUs) { displayLatencyUs = latencyUs; }
+    bool takeShiftReport(ShiftReport& report);
     VehicleData getData() const;
+    LinkHealthSnapshot getLinkHealth() const;
+    // Readable after each new sample or shift report, see takeWakeup()
+    int getWakeFd() const { return wakeFd; }
+    void takeWakeup();
 private:
     void processSerial();
     std::string findArduinoPort();
+    void addHotplugWatches();
+    void waitForHotplug();
+    void wake();
     std::atomic<bool> isRunning;
     VehicleData data;
+    mutable std::mutex dataMutex;
+    LinkHealth linkHealth;
+    TelemetryPublisher telemetryBus;
+    ShiftPredictor shiftPredictor;
     std::thread serialThread;
-    std::atomic_int gearAngle = -1;
-    int fd;
+    ThreadProfile threadProfile;
+    std::atomic_int pendingShift = -1;
+    std::atomic<uint64_t> displayLatencyUs{0};
+    ShiftReport shiftReport;
+    bool shiftReportPending = false;
+    int fd = -1;
+    std::string portPath;
+    int hotplugFd = -1;
+    int devWatch = -1;
+    int byIdWatch = -1;
+    int wakeFd = -1;
 };
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+inline uint64_t monotonicMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <iostream>
 #include <SDL.h>
 #if IS_RASPI
@@ -6,47 +9,36 @@
 #include "Arduino.h"
 #include "Renderer.h"
 #include "VehicleConstants.h"
-
-float calculateSpeed(int rpm, int gear) {
-    if (gear <= 0 || gear > GEAR_RATIOS.size() || rpm == 0) {
-        return 0.0f;
-    }
-    float totalRatio = GEAR_RATIOS[gear-1] * FINAL_DRIVE_RATIO;
-    float wheelCircumference = M_PI * WHEEL_DIAMETER_MM;
-    return (rpm * wheelCircumference * 60.0f) / (totalRatio * 1000000.0f);
-}
+#include "Clock.h"
+#include "ShiftPredictor.h"
+#include "Trace.h"
+#include "Telemetry.h"
+#include "AllocCheck.h"
+#include "Scheduling.h"
+#include <thread>
+#include <unistd.h>
+#include <poll.h>
+#include <sched.h>
 
 int gearGoal = -2;
 bool clutchPressed = false;
 Uint32 lastShiftTime = 0;
-bool servoDetached = false;
 bool canShift = true;
 const Uint32 SHIFT_COOLDOWN_MS = 1400;
-const int BACKLASH_COMPENSATION = 4;
-enum ShiftDirection { SHIFT_NONE, SHIFT_UP, SHIFT_DOWN };
-ShiftDirection lastShiftDirection = SHIFT_NONE;
-
-int getServoAngle(int fromGear, int toGear) {
-    if (fromGear == GEAR_N && toGear == GEAR_1) return SHIFT_DOWN_ANGLE;
-    if (fromGear == GEAR_1 && toGear == GEAR_N) return SHIFT_UP_ANGLE;
-    if (fromGear == GEAR_2 && toGear == GEAR_N) return SHIFT_DOWN_ANGLE - 13;
-    if (toGear == fromGear) return NEUTRAL_ANGLE;
-    if (toGear > fromGear) return SHIFT_UP_ANGLE;
-    if (toGear < fromGear) return SHIFT_DOWN_ANGLE;
-    return NEUTRAL_ANGLE;
-}
+// The firmware gives up after 1 s, this only covers a lost answer
+const Uint32 SHIFT_REPLY_TIMEOUT_MS = 2000;
+// The firmware holds the lever this long after a shift and rejects
+// commands meanwhile
+const Uint32 SHIFT_HOLD_MS = 400;
+bool shiftInFlight = false;
+Uint32 shiftRequestTime = 0;
+Uint32 shiftReportTime = 0;
 
 void shiftUp() {
     if (canShift && gearGoal < GEAR_6 && clutchPressed) {
         gearGoal++;
         lastShiftTime = SDL_GetTicks();
-        servoDetached = false;
         canShift = false;
-        if (gearGoal == GEAR_1) {
-            lastShiftDirection = SHIFT_DOWN;
-            return;
-        }
-        lastShiftDirection = SHIFT_UP;
     }
 }
 
@@ -54,9 +46,7 @@ void shiftDown() {
     if (canShift && gearGoal > GEAR_N && clutchPressed) {
         gearGoal--;
         lastShiftTime = SDL_GetTicks();
-        servoDetached = false;
         canShift = false;
-        lastShiftDirection = SHIFT_DOWN;
     }
 }
 
@@ -64,17 +54,321 @@ const unsigned int PROX_PIN = 14;  // GPIO14 (Pin 8)
 const unsigned int BTN1_PIN = 12;  // GPIO12 (Pin 32)
 const unsigned int BTN2_PIN = 16;  // GPIO16 (Pin 36)
 
-int main() {
-    Arduino arduino;
-    arduino.start();
+// Non-native textures are converted by SDL on every update or draw
+void printTextureStats(const TextureStats& textures) {
+    std::cout << "textures: " << textures.liveBytes / 1024 << " KiB live, " << textures.peakBytes / 1024
+              << " KiB peak, " << textures.pooledBytes / 1024 << " KiB pooled, budget "
+              << textures.budgetBytes / 1024 << " KiB, " << textures.creates << " creates, "
+              << textures.reuses << " reuses, " << textures.destroys << " destroys, "
+              << textures.downgrades << " downgrades, " << textures.nonNative << " non-native, "
+              << textures.overBudget << " over budget" << std::endl;
+    for (int i = 0; i < TEXTURE_PURPOSE_COUNT; ++i) {
+        std::cout << "  " << TextureManager::purposeName(i) << ": " << textures.purposeBytes[i] / 1024 << " KiB" << std::endl;
+    }
+    for (const auto& format : textures.formatBytes) {
+        std::cout << "  " << SDL_GetPixelFormatName(format.first) << ": " << format.second / 1024 << " KiB" << std::endl;
+    }
+}
+
+void printUsage() {
+    std::cerr << "Usage: Cluster [options]" << std::endl
+              << "  --arc-backend=gfx|simd   arc rasterizer" << std::endl
+              << "  --texture-budget=<KiB>   texture memory budget (default "
+              << TEXTURE_BUDGET_BYTES / 1024 << ")" << std::endl
+              << "  --port=<path>            serial device of the Arduino" << std::endl
+              << "  --rt, --no-rt            realtime scheduling profile on or off" << std::endl
+              << "  --cpu-main=<core>, --cpu-serial=<core>" << std::endl
+              << "                           pin a thread to a core, -1 leaves it unpinned" << std::endl
+              << "  --prio-main=<n>, --prio-serial=<n>" << std::endl
+              << "                           SCHED_FIFO priority, 0 keeps SCHED_OTHER" << std::endl
+              << "  --jitter[=<seconds>]     measure wakeup jitter and exit" << std::endl
+              << "  --dump-frame=<file.bmp>  save one fixed frame and exit, SDL_RENDER_DRIVER picks the renderer"
+              << std::endl
+              << "  --bench-arcs, --bench-trace, --alloc-check" << std::endl
+              << "  --widget-stats, --link-stats, --draw-stats, --texture-stats, --shift-stats" << std::endl;
+}
+
+// Whole decimal number in [min, max], nothing trailing
+bool parseNumber(const std::string& text, long min, long max, long& value) {
+    char* end;
+    errno = 0;
+    value = strtol(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0' && errno == 0 && value >= min && value <= max;
+}
+
+// The value after '=' of `arg`, a usage error when it is outside [min, max]
+bool parseOption(const std::string& arg, long min, long max, long& value) {
+    size_t equals = arg.find('=');
+    if (parseNumber(arg.substr(equals + 1), min, max, value)) return true;
+    std::cerr << "Invalid " << arg.substr(0, equals) << " '" << arg.substr(equals + 1) << "', expected "
+              << min << ".." << max << std::endl;
+    printUsage();
+    return false;
+}
+
+// 0 or a SCHED_FIFO priority
+bool parsePriority(const std::string& arg, int& priority) {
+    long value;
+    if (!parseOption(arg, 0, sched_get_priority_max(SCHED_FIFO), value)) return false;
+    if (value != 0 && value < sched_get_priority_min(SCHED_FIFO)) {
+        std::cerr << "Invalid " << arg << ", SCHED_FIFO starts at " << sched_get_priority_min(SCHED_FIFO) << std::endl;
+        printUsage();
+        return false;
+    }
+    priority = (int)value;
+    return true;
+}
+
+const int ALLOC_CHECK_PERIOD = 300;
+const int ALLOC_CHECK_FRAMES = 5000;
+
+// Sweeps every gauge through one period of synthetic data so the warm-up has
+// seen each texture size and glyph before the counter is armed.
+VehicleData allocCheckSample(int frame, uint64_t nowUs) {
+    VehicleData data;
+    int step = frame % ALLOC_CHECK_PERIOD;
+    float ratio = (float)step / ALLOC_CHECK_PERIOD;
+    data.currentGear = step * 7 / ALLOC_CHECK_PERIOD;
+    data.engineRpm = (int)(ratio * RPM_MAX);
+    data.coolantTemp = ratio * 120.0f;
+    data.ambientTemp = ratio * 40.0f - 10.0f;
+    data.voltage = 10.0f + ratio * 5.0f;
+    data.engineLoad = ratio * 100.0f;
+    data.throttle = ratio * 72.0f;
+    data.clutchPressed = step % 50 < 5;
+    data.shiftLight = ratio > 0.8f;
+    data.overRev = ratio > 0.95f;
+    data.sampleTimeUs = nowUs;
+    return data;
+}
+
+int runAllocCheck(Renderer& renderer) {
+    if (!AllocCheck::isEnabled()) {
+        std::cerr << "--alloc-check needs a build configured with -DCLUSTER_ALLOC_CHECK=ON" << std::endl;
+        return 1;
+    }
+    uint64_t nowUs = 0;
+    for (int frame = 0; frame < ALLOC_CHECK_FRAMES + ALLOC_CHECK_PERIOD; ++frame) {
+        if (frame == ALLOC_CHECK_PERIOD) {
+            AllocCheck::arm();
+        }
+        nowUs += 16667;
+        VehicleData data = allocCheckSample(frame, nowUs);
+        float speed = data.clutchPressed ? -1.0f : calculateSpeed(data.engineRpm, data.currentGear);
+        renderer.render(data, speed, nowUs);
+    }
+    AllocCheck::disarm();
+    uint64_t allocations = AllocCheck::allocations();
+    std::cout << "alloc-check: " << allocations << " operator new in " << ALLOC_CHECK_FRAMES
+              << " frames, frame arena high water " << renderer.getFrameArenaHighWater() << " bytes" << std::endl;
+    // SDL_ttf renders every changed text into a fresh surface, so only our
+    // own operator new has to stay at zero
+    if (AllocCheck::countsMalloc()) {
+        std::cout << "alloc-check: " << AllocCheck::mallocs() << " malloc/calloc/realloc, "
+                  << (double)AllocCheck::mallocs() / ALLOC_CHECK_FRAMES << " per frame (SDL and SDL_ttf included)"
+                  << std::endl;
+    } else {
+        std::cout << "alloc-check: malloc is not counted without glibc" << std::endl;
+    }
+    std::cout << "alloc-check: " << (allocations == 0 ? "ok" : "FAILED") << std::endl;
+    return allocations == 0 ? 0 : 1;
+}
+
+const int DUMP_FRAME_STEP = 130;
+const int DUMP_FRAMES = 120;
+
+// One alloc-check sample with a gear goal on top, held until the needle
+// settled, so dumps of different renderers and builds can be compared
+int runFrameDump(Renderer& renderer, const std::string& path) {
+    uint64_t nowUs = 0;
+    VehicleData data = allocCheckSample(DUMP_FRAME_STEP, nowUs);
+    data.gearGoal = data.currentGear + 1;
+    for (int frame = 0; frame < DUMP_FRAMES; ++frame) {
+        nowUs += 16667;
+        data.sampleTimeUs = nowUs;
+        renderer.render(data, calculateSpeed(data.engineRpm, data.currentGear), nowUs);
+    }
+    if (!renderer.saveFrame(path)) return 1;
+    std::cout << "frame saved to " << path << std::endl;
+    return 0;
+}
+
+void printJitter(const char* name, const ThreadProfile& profile, const JitterStats& stats) {
+    std::cout << "jitter " << name << " (core " << profile.core << ", "
+              << (profile.priority > 0 ? "FIFO " + std::to_string(profile.priority) : std::string("CFS")) << "): "
+              << stats.samples << " wake-ups every " << JITTER_INTERVAL_US << " us, latency min " << stats.minUs
+              << " us, avg " << stats.avgUs << " us, p99 " << stats.percentileUs(99.0) << " us, p99.9 "
+              << stats.percentileUs(99.9) << " us, max " << stats.maxUs << " us, " << stats.overflows
+              << " over " << JITTER_HISTOGRAM_US << " us" << std::endl;
+}
+
+// One periodic thread per configured thread, both at once like cyclictest -t
+int runJitter(const SchedulingProfile& profile, int seconds) {
+    if (profile.lockMemory) {
+        Scheduling::lockMemory();
+    }
+    JitterStats mainStats, serialStats;
+    std::thread serial([&] { Scheduling::measureJitter(profile.serial, "serial thread", seconds, serialStats); });
+    Scheduling::measureJitter(profile.main, "main loop", seconds, mainStats);
+    serial.join();
+    printJitter("main loop", profile.main, mainStats);
+    printJitter("serial thread", profile.serial, serialStats);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    ArcBackend arcBackend = ArcBackend::Gfx;
+    bool benchArcs = false;
+    bool widgetStats = false;
+    bool linkStats = false;
+    bool drawStats = false;
+    bool textureStats = false;
+    bool benchTrace = false;
+    bool allocCheck = false;
+    bool shiftStats = false;
+    size_t textureBudget = TEXTURE_BUDGET_BYTES;
+#if IS_RASPI
+    bool realtime = true;
+#else
+    bool realtime = false;
+#endif
+    ThreadProfile mainOverride{-2, -1};
+    ThreadProfile serialOverride{-2, -1};
+    int jitterSeconds = 0;
+    const long cores = sysconf(_SC_NPROCESSORS_CONF);
+    std::string port;
+    std::string dumpPath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--arc-backend=simd") {
+            arcBackend = ArcBackend::Simd;
+        } else if (arg == "--arc-backend=gfx") {
+            arcBackend = ArcBackend::Gfx;
+        } else if (arg == "--bench-arcs") {
+            benchArcs = true;
+        } else if (arg == "--widget-stats") {
+            widgetStats = true;
+        } else if (arg == "--link-stats") {
+            linkStats = true;
+        } else if (arg == "--draw-stats") {
+            drawStats = true;
+        } else if (arg == "--bench-trace") {
+            benchTrace = true;
+        } else if (arg == "--shift-stats") {
+            shiftStats = true;
+        } else if (arg == "--alloc-check") {
+            allocCheck = true;
+        } else if (arg == "--texture-stats") {
+            textureStats = true;
+        } else if (arg.rfind("--texture-budget=", 0) == 0) {
+            long kib;
+            if (!parseOption(arg, 1, 1024 * 1024, kib)) return 1;
+            textureBudget = (size_t)kib * 1024;
+        } else if (arg.rfind("--dump-frame=", 0) == 0) {
+            dumpPath = arg.substr(13);
+            if (dumpPath.empty()) {
+                std::cerr << "--dump-frame needs a file name" << std::endl;
+                printUsage();
+                return 1;
+            }
+        } else if (arg.rfind("--port=", 0) == 0) {
+            port = arg.substr(7);
+        } else if (arg == "--rt") {
+            realtime = true;
+        } else if (arg == "--no-rt") {
+            realtime = false;
+        } else if (arg.rfind("--cpu-main=", 0) == 0) {
+            long core;
+            if (!parseOption(arg, -1, cores - 1, core)) return 1;
+            mainOverride.core = (int)core;
+        } else if (arg.rfind("--cpu-serial=", 0) == 0) {
+            long core;
+            if (!parseOption(arg, -1, cores - 1, core)) return 1;
+            serialOverride.core = (int)core;
+        } else if (arg.rfind("--prio-main=", 0) == 0) {
+            if (!parsePriority(arg, mainOverride.priority)) return 1;
+        } else if (arg.rfind("--prio-serial=", 0) == 0) {
+            if (!parsePriority(arg, serialOverride.priority)) return 1;
+        } else if (arg == "--jitter") {
+            jitterSeconds = 10;
+        } else if (arg.rfind("--jitter=", 0) == 0) {
+            long seconds;
+            if (!parseOption(arg, 1, 3600, seconds)) return 1;
+            jitterSeconds = (int)seconds;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (benchTrace) {
+        TraceBenchmark bench = Trace::benchmark(1000000);
+        std::cout << "trace: zone " << bench.zoneNs << " ns, counter " << bench.counterNs
+                  << " ns, clock read " << bench.clockNs << " ns"
+                  << (CLUSTER_TRACING ? "" : " (macros compiled out in this build)") << std::endl;
+        return 0;
+    }
+
+    // --cpu-*=-1 and --prio-*=0 switch a single part of the profile off
+    SchedulingProfile profile = realtime ? Scheduling::realtimeProfile() : SchedulingProfile();
+    if (mainOverride.core != -2) profile.main.core = mainOverride.core;
+    if (serialOverride.core != -2) profile.serial.core = serialOverride.core;
+    if (mainOverride.priority != -1) profile.main.priority = mainOverride.priority;
+    if (serialOverride.priority != -1) profile.serial.priority = serialOverride.priority;
+
+    if (jitterSeconds > 0) {
+        return runJitter(profile, jitterSeconds);
+    }
+    if (profile.lockMemory) {
+        Scheduling::lockMemory();
+    }
+
+    TRACE_THREAD_NAME("main");
+    Trace::installSignalHandler();
+    int traceDumps = 0;
 
     Renderer renderer(800, 480);
+    renderer.setArcBackend(arcBackend);
+    renderer.setTextureBudget(textureBudget);
+    renderer.setHeadless(allocCheck);
     renderer.start();
 
+    if (allocCheck) {
+        int result = runAllocCheck(renderer);
+        if (textureStats) {
+            printTextureStats(renderer.getTextureStats());
+        }
+        return result;
+    }
+
+    if (benchArcs) {
+        renderer.benchmarkArcs(1000);
+        return 0;
+    }
+    if (!dumpPath.empty()) {
+        return runFrameDump(renderer, dumpPath);
+    }
+
+    Arduino arduino;
+    if (!port.empty()) {
+        arduino.setPort(port);
+    }
+    arduino.setThreadProfile(profile.serial);
+    arduino.start();
+
+    // Only now, the SDL/GL driver threads started by the renderer would
+    // otherwise inherit the core and the FIFO policy
+    Scheduling::applyToCurrentThread(profile.main, "main loop");
+
     SDL_Event event;
     bool running = true;
 
     VehicleData data;
+    unsigned long frame = 0;
+#if not IS_RASPI
+    ShiftPredictor shiftPredictor;
+#endif
 
     lastShiftTime = SDL_GetTicks();
 #if IS_RASPI
@@ -83,11 +377,19 @@ int main() {
     struct gpiod_line *lineBtn1 = gpiod_chip_get_line(chip, BTN1_PIN);
     struct gpiod_line *lineBtn2 = gpiod_chip_get_line(chip, BTN2_PIN);
 
-    gpiod_line_request_input_flags(lineProx, "cluster", GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_UP);
-    gpiod_line_request_input_flags(lineBtn1, "cluster", GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_UP);
-    gpiod_line_request_input_flags(lineBtn2, "cluster", GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_UP);
+    // Edge events only wake the idle loop, the levels are still read every pass
+    struct gpiod_line* inputLines[] = {lineProx, lineBtn1, lineBtn2};
+    struct pollfd wakeFds[4] = {{arduino.getWakeFd(), POLLIN, 0}};
+    for (int i = 0; i < 3; ++i) {
+        gpiod_line_request_both_edges_events_flags(inputLines[i], "cluster", GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_UP);
+        wakeFds[i + 1] = {gpiod_line_event_get_fd(inputLines[i]), POLLIN, 0};
+    }
 #endif
     while (running) {
+        // Taken before the snapshot, which then already carries the gear the
+        // report engaged (the firmware sends that telemetry line first)
+        ShiftReport report;
+        bool reported = arduino.takeShiftReport(report);
 #if not IS_RASPI
         data.engineRpm += 100;
         if (data.engineRpm > RPM_MAX) {
@@ -99,6 +401,13 @@ int main() {
             data.clutchPressed = clutchPressed = !data.clutchPressed;
         }
         data.ambientTemp = 20.5;
+        data.sampleTimeUs = monotonicMicros();
+        if (renderer.getDisplayLatencyUs()) {
+            shiftPredictor.setDisplayLatency(renderer.getDisplayLatencyUs());
+        }
+        shiftPredictor.addSample(data.sampleTimeUs, data.engineRpm, data.currentGear);
+        data.shiftLight = shiftPredictor.isShiftLightOn();
+        data.overRev = shiftPredictor.isOverRev();
         data.voltage = ((float)data.engineRpm / RPM_MAX) * 15.0f;
         data.coolantTemp = ((float)data.engineRpm / RPM_MAX) * THROTTLE_MAX;
         data.engineLoad = ((float)data.engineRpm / RPM_MAX) * 100.0f;
@@ -119,15 +428,22 @@ int main() {
             }
         }
 #else
-        data = arduino.getData();
+        {
+            TRACE_ZONE("arduino.snapshot");
+            data = arduino.getData();
+        }
 
         if (gearGoal == -2) {
             gearGoal = data.currentGear;
         }
 
-        int proximity = gpiod_line_get_value(lineProx);
-        int button1 = gpiod_line_get_value(lineBtn1);
-        int button2 = gpiod_line_get_value(lineBtn2);
+        int proximity, button1, button2;
+        {
+            TRACE_ZONE("gpio.sample");
+            proximity = gpiod_line_get_value(lineProx);
+            button1 = gpiod_line_get_value(lineBtn1);
+            button2 = gpiod_line_get_value(lineBtn2);
+        }
 
         data.clutchPressed = clutchPressed = proximity == 0;
 
@@ -140,29 +456,43 @@ int main() {
         }
 #endif
 
-        Uint32 now = SDL_GetTicks();
-        if (!canShift && (now - lastShiftTime > SHIFT_COOLDOWN_MS)) {
-            canShift = true;
-        }
-
-        if (gearGoal == data.currentGear) {
-            if (!servoDetached && (now - lastShiftTime > SHIFT_COOLDOWN_MS)) {
-                arduino.setGearAngle(GEAR_NONE);
-                servoDetached = true;
-            } else if (!servoDetached) {
-                int compensatedAngle = NEUTRAL_ANGLE;
-                if (lastShiftDirection == SHIFT_UP) {
-                    compensatedAngle = NEUTRAL_ANGLE + BACKLASH_COMPENSATION;
-                } else if (lastShiftDirection == SHIFT_DOWN) {
-                    compensatedAngle = NEUTRAL_ANGLE - BACKLASH_COMPENSATION;
+        {
+            TRACE_ZONE("shift.decide");
+            Uint32 now = SDL_GetTicks();
+            if (!canShift && (now - lastShiftTime > SHIFT_COOLDOWN_MS)) {
+                canShift = true;
+            }
+
+            // The firmware runs the servo and answers once the gear engaged
+            // or it gave up, a goal it could not reach is dropped
+            if (reported) {
+                shiftInFlight = false;
+                shiftReportTime = now;
+                if (report.result != SHIFT_ENGAGED) {
+                    gearGoal = data.currentGear;
+                }
+                TRACE_COUNTER("shift.ms", report.durationMs);
+                if (shiftStats) {
+                    static const char* results[] = {"engaged", "timeout", "rejected"};
+                    std::cout << "shift " << report.fromGear << " -> " << report.toGear << ": "
+                              << (report.result >= 0 && report.result <= SHIFT_REJECTED ? results[report.result] : "unknown")
+                              << " after " << report.durationMs << " ms" << std::endl;
                 }
-                arduino.setGearAngle(compensatedAngle);
+            } else if (shiftInFlight && now - shiftRequestTime > SHIFT_REPLY_TIMEOUT_MS) {
+                shiftInFlight = false;
+                gearGoal = data.currentGear;
             }
-        } else {
-            int angle = getServoAngle(data.currentGear, gearGoal);
-            arduino.setGearAngle(angle);
-            lastShiftTime = SDL_GetTicks();
-            servoDetached = false;
+
+            // One gear per request, the firmware only runs single steps. The
+            // goal stays until the car reaches it.
+            if (!shiftInFlight && gearGoal >= GEAR_N && data.currentGear >= GEAR_N && gearGoal != data.currentGear
+                && now - shiftReportTime >= SHIFT_HOLD_MS) {
+                int step = gearGoal > data.currentGear ? 1 : -1;
+                arduino.requestShift(data.currentGear, data.currentGear + step);
+                shiftInFlight = true;
+                shiftRequestTime = now;
+            }
+            TRACE_COUNTER("gearGoal", gearGoal);
         }
 
         float calculatedSpeed = calculateSpeed(data.engineRpm, data.currentGear);
@@ -171,7 +501,61 @@ int main() {
         }
 
         data.gearGoal = data.currentGear == gearGoal ? GEAR_NONE : gearGoal;
-        renderer.render(data, calculatedSpeed);
-        SDL_Delay(16);
+        renderer.render(data, calculatedSpeed, monotonicMicros());
+        arduino.setDisplayLatency(renderer.getDisplayLatencyUs());
+
+        if (++frame % 600 == 0) {
+            if (widgetStats) {
+                for (const WidgetStats& stats : renderer.getWidgetStats()) {
+                    std::cout << stats.name << ": " << stats.hits << " hits, " << stats.misses << " misses" << std::endl;
+                }
+            }
+            if (drawStats) {
+                DrawStats draws = renderer.getDrawStats();
+                std::cout << "icons: " << draws.commands << " sprites in " << draws.drawCalls << " draw calls, "
+                          << draws.stateChanges << " state changes (unbatched: " << draws.commands << " draw calls, "
+                          << draws.unbatchedStateChanges << " state changes)" << std::endl;
+            }
+            if (textureStats) {
+                printTextureStats(renderer.getTextureStats());
+            }
+            if (linkStats) {
+                LinkHealthSnapshot link = arduino.getLinkHealth();
+                std::cout << "link: " << (link.connected ? "connected" : "disconnected")
+                          << ", " << link.bytes << " bytes, " << link.frames << " frames, "
+                          << link.parseErrors << " parse errors, " << link.gaps << " gaps, "
+                          << link.reconnects << " connects, sample age " << link.sampleAgeUs / 1000 << " ms, CAN "
+                          << link.canReceived << " received, " << link.canDropped << " dropped, "
+                          << link.canIgnored << " ignored"
+                          << (link.stale ? " (stale)" : "") << std::endl;
+            }
+        }
+        if (Trace::takeDumpRequest()) {
+            std::string tracePath = "/tmp/cluster-trace-" + std::to_string(getpid()) + "-" + std::to_string(traceDumps++) + ".json";
+            if (Trace::writeChromeJson(tracePath)) {
+                std::cout << "Trace written to " << tracePath << std::endl;
+            }
+        }
+
+        // Animating frames are paced by vsync and the frame interval. An idle
+        // gauge sleeps until new telemetry, a button edge or its refresh.
+        uint64_t nowUs = monotonicMicros();
+        uint64_t nextFrameUs = renderer.getNextFrameUs();
+        int timeoutMs = nextFrameUs > nowUs ? (int)((nextFrameUs - nowUs + 999) / 1000) : 0;
+#if IS_RASPI
+        if (timeoutMs > 0 && poll(wakeFds, renderer.isAnimating() ? 0 : 4, timeoutMs) > 0) {
+            if (wakeFds[0].revents & POLLIN) {
+                arduino.takeWakeup();
+            }
+            for (int i = 0; i < 3; ++i) {
+                struct gpiod_line_event edge;
+                if (wakeFds[i + 1].revents & POLLIN) {
+                    gpiod_line_event_read(inputLines[i], &edge);
+                }
+            }
+        }
+#else
+        SDL_WaitEventTimeout(NULL, timeoutMs);
+#endif
     }
 }
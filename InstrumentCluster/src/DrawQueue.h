@@ -0,0 +1,38 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "FixedVector.h"
+
+const size_t DRAW_QUEUE_CAPACITY = 128;
+
+struct DrawStats {
+    int commands;
+    int drawCalls;
+    int stateChanges;
+    int unbatchedStateChanges;
+};
+
+// Collects textured quads for a frame and submits them sorted by texture and
+// blend mode, one SDL_RenderGeometry call per run. Tint is passed as vertex
+// color instead of SDL_SetTextureColorMod, so differently tinted sprites of
+// one texture still share a batch. Sorting changes the painter's order between
+// textures, only queue sprites that don't overlap.
+class DrawQueue {
+public:
+    void push(SDL_Texture* texture, SDL_BlendMode blendMode, const SDL_Rect& src, const SDL_Rect& dst, SDL_Color color);
+    void flush(SDL_Renderer* renderer);
+    DrawStats getStats() const { return stats; }
+private:
+    struct Command {
+        SDL_Texture* texture;
+        SDL_BlendMode blendMode;
+        int sequence;
+        SDL_Vertex vertices[4];
+    };
+    FixedVector<Command, DRAW_QUEUE_CAPACITY> commands;
+    FixedVector<SDL_Vertex, DRAW_QUEUE_CAPACITY * 4> vertices;
+    FixedVector<int, DRAW_QUEUE_CAPACITY * 6> indices;
+    DrawStats stats = {0, 0, 0, 0};
+    int unbatchedStateChanges = 0;
+    bool overflowReported = false;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+// String with inline storage for the hot paths. Appends that don't fit are
+// cut off, the contents stay null terminated.
+template <size_t Capacity>
+class FixedString {
+public:
+    FixedString() { data[0] = '\0'; }
+
+    void clear() {
+        length = 0;
+        data[0] = '\0';
+        truncated = false;
+    }
+
+    FixedString& append(char c) {
+        if (length < Capacity) {
+            data[length++] = c;
+            data[length] = '\0';
+        } else {
+            truncated = true;
+        }
+        return *this;
+    }
+
+    FixedString& append(const char* text) {
+        while (*text) append(*text++);
+        return *this;
+    }
+
+    // minDigits pads with leading zeros
+    FixedString& appendInt(long value, int minDigits = 1) {
+        char digits[24];
+        int count = 0;
+        unsigned long magnitude = value < 0 ? 0ul - (unsigned long)value : (unsigned long)value;
+        do {
+            digits[count++] = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+        while (count < minDigits && count < (int)sizeof(digits)) digits[count++] = '0';
+        if (value < 0) append('-');
+        while (count > 0) append(digits[--count]);
+        return *this;
+    }
+
+    // Fixed point value given as an integer count of 1/10^decimals
+    FixedString& appendFixed(long scaled, int decimals) {
+        long divisor = 1;
+        for (int i = 0; i < decimals; ++i) divisor *= 10;
+        if (scaled < 0) {
+            append('-');
+            scaled = -scaled;
+        }
+        appendInt(scaled / divisor);
+        if (decimals > 0) {
+            append('.');
+            appendInt(scaled % divisor, decimals);
+        }
+        return *this;
+    }
+
+    const char* c_str() const { return data; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    bool isTruncated() const { return truncated; }
+    char operator[](size_t index) const { return data[index]; }
+private:
+    char data[Capacity + 1];
+    size_t length = 0;
+    bool truncated = false;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+// Vector with inline storage. push_back() on a full vector is refused and
+// reported, so callers can count or skip instead of reallocating.
+template <typename T, size_t Capacity>
+class FixedVector {
+public:
+    bool push_back(const T& value) {
+        if (count == Capacity) return false;
+        items[count++] = value;
+        return true;
+    }
+
+    void clear() { count = 0; }
+    bool full() const { return count == Capacity; }
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    static constexpr size_t capacity() { return Capacity; }
+
+    T* data() { return items; }
+    const T* data() const { return items; }
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+    T& operator[](size_t index) { return items[index]; }
+    const T& operator[](size_t index) const { return items[index]; }
+    T& back() { return items[count - 1]; }
+    const T& back() const { return items[count - 1]; }
+private:
+    T items[Capacity];
+    size_t count = 0;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+const size_t FRAME_ARENA_BYTES = 16 * 1024;
+
+// Bump allocator for scratch arrays that live for one frame at most. reset()
+// at the start of a frame hands the whole block out again.
+class FrameArena {
+public:
+    void reset() {
+        used = 0;
+    }
+
+    // Returns nullptr when the frame asked for more than FRAME_ARENA_BYTES
+    template <typename T>
+    T* allocate(size_t count) {
+        size_t offset = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+        if (offset + count * sizeof(T) > FRAME_ARENA_BYTES) {
+            exhausted++;
+            return nullptr;
+        }
+        used = offset + count * sizeof(T);
+        if (used > highWater) highWater = used;
+        return reinterpret_cast<T*>(storage + offset);
+    }
+
+    size_t getHighWater() const { return highWater; }
+    unsigned long getExhausted() const { return exhausted; }
+private:
+    alignas(16) uint8_t storage[FRAME_ARENA_BYTES];
+    size_t used = 0;
+    size_t highWater = 0;
+    unsigned long exhausted = 0;
+};
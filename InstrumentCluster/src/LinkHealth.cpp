@@ -0,0 +1,48 @@
+#include "LinkHealth.h"
+
+void LinkHealth::onConnect() {
+    reconnects++;
+    connected = true;
+}
+
+void LinkHealth::onDisconnect() {
+    connected = false;
+}
+
+void LinkHealth::onBytes(uint64_t count) {
+    bytes += count;
+}
+
+void LinkHealth::onFrame(uint64_t timeUs) {
+    uint64_t previous = lastFrameUs.exchange(timeUs);
+    if (previous != 0 && timeUs - previous > LINK_GAP_US) {
+        gaps++;
+    }
+    frames++;
+}
+
+void LinkHealth::onParseError() {
+    parseErrors++;
+}
+
+void LinkHealth::onFirmwareStatus(uint64_t received, uint64_t dropped, uint64_t ignored) {
+    canReceived = received;
+    canDropped = dropped;
+    canIgnored = ignored;
+}
+
+bool LinkHealth::isStale(uint64_t nowUs) const {
+    uint64_t last = lastFrameUs;
+    return !connected || last == 0 || (nowUs > last && nowUs - last > LINK_STALE_US);
+}
+
+LinkHealthSnapshot LinkHealth::snapshot(uint64_t nowUs) const {
+    uint64_t last = lastFrameUs;
+    return {
+        bytes, frames, parseErrors, gaps, reconnects,
+        last && nowUs > last ? nowUs - last : 0,
+        canReceived, canDropped, canIgnored,
+        connected,
+        isStale(nowUs)
+    };
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+const uint64_t LINK_GAP_US = 200000;
+const uint64_t LINK_STALE_US = 500000;
+
+struct LinkHealthSnapshot {
+    uint64_t bytes;
+    uint64_t frames;
+    uint64_t parseErrors;
+    uint64_t gaps;
+    uint64_t reconnects;
+    uint64_t sampleAgeUs;
+    uint64_t canReceived;
+    uint64_t canDropped;
+    uint64_t canIgnored;
+    bool connected;
+    bool stale;
+};
+
+// Counters of the serial link, written by the serial thread and read from
+// anywhere. A gap is an interval between two good frames above LINK_GAP_US.
+// The CAN counters are the last ones the firmware reported in an "S:" line.
+class LinkHealth {
+public:
+    void onConnect();
+    void onDisconnect();
+    void onBytes(uint64_t count);
+    void onFrame(uint64_t timeUs);
+    void onParseError();
+    void onFirmwareStatus(uint64_t canReceived, uint64_t canDropped, uint64_t canIgnored);
+    bool isStale(uint64_t nowUs) const;
+    LinkHealthSnapshot snapshot(uint64_t nowUs) const;
+private:
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> parseErrors{0};
+    std::atomic<uint64_t> gaps{0};
+    std::atomic<uint64_t> reconnects{0};
+    std::atomic<uint64_t> lastFrameUs{0};
+    std::atomic<uint64_t> canReceived{0};
+    std::atomic<uint64_t> canDropped{0};
+    std::atomic<uint64_t> canIgnored{0};
+    std::atomic<bool> connected{false};
+};
@@ -1,11 +1,13 @@
 #include "Renderer.h"
+#include "Trace.h"
+#include "FixedString.h"
+#include "Clock.h"
 #include <iostream>
-#include <sstream>
 #include <cmath>
-#include <iomanip>
 #include <SDL2/SDL2_gfxPrimitives.h>
 #include <SDL2/SDL_image.h>
 #include <vector>
+#include <array>
 
 Renderer::Renderer(int width, int height) : window(nullptr), renderer(nullptr), width(width), height(height){
     centerX = width / 2;
@@ -21,6 +23,11 @@ Renderer::Renderer(int width, int height) : window(nullptr), renderer(nullptr),
 }
 
 Renderer::~Renderer(){
+    arcRasterizer.release();
+    for (CachedWidget<int>* widget : {&gearWidget, &gearGoalWidget, &speedWidget, &batteryWidget, &ambientWidget, &coolantWidget}) {
+        widget->release();
+    }
+    textures.clear();
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
@@ -30,6 +37,9 @@ void Renderer::start(){
 #if IS_RASPI
     setenv("SDL_VIDEODRIVER", "kmsdrm", 1);
 #endif
+    if (headless) {
+        setenv("SDL_VIDEODRIVER", "offscreen", 1);
+    }
 
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         std::cerr << "SDL Init Failed: " << SDL_GetError() << std::endl;
@@ -50,18 +60,21 @@ void Renderer::start(){
 #else
         SDL_WINDOW_SHOWN
 #endif
+        | (headless ? SDL_WINDOW_HIDDEN : 0)
     );
 
 #if IS_RASPI
     SDL_ShowCursor(SDL_DISABLE);
 #endif
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-    renderTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    renderer = SDL_CreateRenderer(window, -1, headless ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    textures.init(renderer, textureBudget);
+    renderTexture = textures.acquire(TEXTURE_TARGET, textures.getNativeFormat(), SDL_TEXTUREACCESS_TARGET, width, height);
     if (!renderTexture) {
-        std::cerr << "SDL_CreateTexture Error: " << SDL_GetError() << std::endl;
         return;
     }
+    // Opaque layers are copied, not blended
+    SDL_SetTextureBlendMode(renderTexture, SDL_BLENDMODE_NONE);
     std::string a = ASSET_PATH;
     gearFont = TTF_OpenFont((a + "trans.ttf").c_str(), 270);
     gearGoalFont = TTF_OpenFont((a + "trans.ttf").c_str(), 80);
@@ -69,41 +82,197 @@ void Renderer::start(){
     numberFont = TTF_OpenFont((a + "trans.ttf").c_str(), 58);
     trackFont = TTF_OpenFont((a + "trans.ttf").c_str(), 26);
     infoFont = TTF_OpenFont((a + "bebas.ttf").c_str(), 50);
-    bgTexture = loadTexture((a + "bg.png").c_str());
-    tempTexture = loadTexture((a + "temp.png").c_str());
-    coolantTexture = loadTexture((a + "coolant.png").c_str());
-    engineLoadTexture = loadTexture((a + "load.png").c_str());
-    batteryTexture = loadTexture((a + "battery.png").c_str());
-    throttleTexture = loadTexture((a + "throttle.png").c_str());
-    clutchTexture = loadTexture((a + "clutch.png").c_str());
-    absTexture = loadTexture((a + "abs.png").c_str());
-    tcTexture = loadTexture((a + "tc.png").c_str());
+    bgTexture = loadBackground(a + "bg.png");
+    iconAtlas.build(textures, {
+        a + "temp.png", a + "coolant.png", a + "load.png", a + "battery.png",
+        a + "throttle.png", a + "clutch.png", a + "abs.png", a + "tc.png"
+    });
     preRenderBackground();
+    preRenderNumbers();
+    SDL_Surface* staleSurface = TTF_RenderText_Blended(infoFont, "NO DATA", {255, 20, 20, 255});
+    staleTexture = textures.acquireFromSurface(TEXTURE_TEXT, staleSurface);
+    staleRect = {(width - staleSurface->w) / 2, 20, staleSurface->w, staleSurface->h};
+    SDL_FreeSurface(staleSurface);
     bgRect = {0, 0, width, height};
+    if (arcBackend == ArcBackend::Simd) {
+        arcRasterizer.init(textures, width, height, centerX, centerY);
+    }
+    // The baked background never changes, move it to a smaller format if the rest doesn't fit
+    renderedBackgroundTexture = textures.compact(renderedBackgroundTexture, TEXTURE_BACKGROUND);
+    SDL_SetTextureBlendMode(renderedBackgroundTexture, SDL_BLENDMODE_NONE);
+    if (textures.isOverBudget()) {
+        TextureStats stats = textures.getStats();
+        std::cerr << "Textures need " << stats.liveBytes / 1024 << " KiB, over the budget of "
+                  << stats.budgetBytes / 1024 << " KiB" << std::endl;
+    }
 }
 
-void Renderer::render(const VehicleData& data, float speed){
-    smoothedRpm = smoothingFactor * data.engineRpm + (1 - smoothingFactor) * smoothedRpm;
-    smoothedLoad = smoothingFactor * data.engineLoad + (1 - smoothingFactor) * smoothedLoad;
-    smoothedThrottle = smoothingFactor * data.throttle + (1 - smoothingFactor) * smoothedThrottle;
+void Renderer::setTextureBudget(size_t bytes) {
+    textureBudget = bytes;
+    textures.setBudget(bytes);
+}
+
+void Renderer::setArcBackend(ArcBackend backend) {
+    arcBackend = backend;
+    if (arcBackend == ArcBackend::Simd && renderer && !arcRasterizer.isInitialized()) {
+        arcRasterizer.init(textures, width, height, centerX, centerY);
+    }
+}
+
+void Renderer::benchmarkArcs(int frames) {
+    ArcBackend previousBackend = arcBackend;
+    SDL_Rect probeRect = {centerX, centerY, 1, 1};
+    Uint32 probePixel;
+    for (ArcBackend backend : {ArcBackend::Gfx, ArcBackend::Simd}) {
+        setArcBackend(backend);
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < frames; ++i) {
+            float ratio = (float)(i % 100) / 100.0f;
+            smoothedRpm = ratio * RPM_MAX;
+            smoothedLoad = ratio * 100.0f;
+            smoothedThrottle = ratio * THROTTLE_MAX;
+            SDL_SetRenderTarget(renderer, renderTexture);
+            SDL_RenderClear(renderer);
+            renderArcs();
+            // Reading back a pixel forces the GPU to finish the frame
+            SDL_RenderReadPixels(renderer, &probeRect, textures.getNativeFormat(), &probePixel, 4);
+        }
+        double elapsedMs = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+        std::cout << (backend == ArcBackend::Gfx ? "gfx " : "simd") << " arcs: "
+                  << elapsedMs * 1000.0 / frames << " us/frame over " << frames << " frames" << std::endl;
+    }
+    SDL_SetRenderTarget(renderer, NULL);
+    setArcBackend(previousBackend);
+}
 
+bool Renderer::saveFrame(const std::string& path) {
+    SDL_Surface* frame = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!frame) {
+        std::cerr << "SDL_CreateRGBSurfaceWithFormat Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
     SDL_SetRenderTarget(renderer, renderTexture);
+    int result = SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ARGB8888, frame->pixels, frame->pitch);
+    SDL_SetRenderTarget(renderer, NULL);
+    if (result != 0) {
+        std::cerr << "SDL_RenderReadPixels Error: " << SDL_GetError() << std::endl;
+    } else if (SDL_SaveBMP(frame, path.c_str()) != 0) {
+        std::cerr << "SDL_SaveBMP Error: " << SDL_GetError() << std::endl;
+        result = -1;
+    }
+    SDL_FreeSurface(frame);
+    return result == 0;
+}
 
-    SDL_RenderClear(renderer);
+void Renderer::update(const VehicleData& data, uint64_t nowUs) {
+    uint64_t sampleTimeUs = data.sampleTimeUs ? data.sampleTimeUs : nowUs;
+    if (sampleTimeUs != lastSampleTimeUs) {
+        rpmTrack.push(sampleTimeUs, data.engineRpm);
+        loadTrack.push(sampleTimeUs, data.engineLoad);
+        throttleTrack.push(sampleTimeUs, data.throttle);
+        lastSampleTimeUs = sampleTimeUs;
+    }
+    rpmTarget = rpmTrack.sample(nowUs);
+    loadTarget = loadTrack.sample(nowUs);
+    throttleTarget = throttleTrack.sample(nowUs);
+
+    float dt = lastUpdateUs ? std::min((float)(nowUs - lastUpdateUs) / 1e6f, MAX_ANIMATION_STEP) : 0.0f;
+    lastUpdateUs = nowUs;
+    rpmFilter.update(rpmTarget, dt);
+    loadFilter.update(loadTarget, dt);
+    throttleFilter.update(throttleTarget, dt);
+    smoothedRpm = rpmFilter.value();
+    smoothedLoad = loadFilter.value();
+    smoothedThrottle = throttleFilter.value();
+
+    if (data.shiftLight || smoothedRpm >= WARNING_LIGHTS_RPM) {
+        if (!warningActive) {
+            warningActive = true;
+            warningStartUs = nowUs;
+        }
+    } else {
+        warningActive = false;
+    }
+    if (data.overRev || smoothedRpm >= WARNING_ARC_RPM) {
+        if (!rpmFlashActive) {
+            rpmFlashActive = true;
+            rpmFlashStartUs = nowUs;
+        }
+    } else {
+        rpmFlashActive = false;
+    }
+}
+
+bool Renderer::isAnimating() const {
+    return warningActive || rpmFlashActive
+        || !rpmFilter.settled(rpmTarget, 1.0f)
+        || !loadFilter.settled(loadTarget, 0.05f)
+        || !throttleFilter.settled(throttleTarget, 0.05f);
+}
+
+// When the main loop has to call render() again, earlier if the data changes
+uint64_t Renderer::getNextFrameUs() const {
+    return lastFrameUs + (isAnimating() ? activeFrameIntervalUs : idleFrameIntervalUs);
+}
+
+std::vector<WidgetStats> Renderer::getWidgetStats() const {
+    return {gearWidget.stats(), gearGoalWidget.stats(), speedWidget.stats(),
+            batteryWidget.stats(), ambientWidget.stats(), coolantWidget.stats()};
+}
+
+bool Renderer::render(const VehicleData& data, float speed, uint64_t nowUs){
+    TRACE_ZONE("render.frame");
+    frameArena.reset();
+    update(data, nowUs);
 
-    SDL_RenderCopy(renderer, renderedBackgroundTexture, NULL, &bgRect);
+    // While nothing moves only refresh at a low rate
+    std::array<int, 8> frameKey = {
+        data.currentGear, data.gearGoal, speed != -1.0f ? (int)speed : -1, data.clutchPressed, data.stale,
+        (int)lroundf(data.voltage * 10.0f), (int)lroundf(data.ambientTemp * 10.0f), (int)lroundf(data.coolantTemp * 10.0f)
+    };
+    if (!isAnimating() && frameKey == lastFrameKey && nowUs - lastFrameUs < idleFrameIntervalUs) {
+        return false;
+    }
+    lastFrameKey = frameKey;
+    lastFrameUs = nowUs;
+
+    {
+        TRACE_ZONE("render.background");
+        SDL_SetRenderTarget(renderer, renderTexture);
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, renderedBackgroundTexture, NULL, &bgRect);
+    }
 
+    renderArcs();
     renderGear(data.currentGear);
     renderGear(data.gearGoal, true);
     renderSpeed(speed);
     renderRPM();
-    renderLoadThrottleBars();
+    renderLoadThrottleIcons();
     renderInfoTexts(data.ambientTemp, data.coolantTemp, data.voltage, data.clutchPressed);
+    {
+        TRACE_ZONE("render.flush");
+        drawQueue.flush(renderer);
+    }
+    if (data.stale) {
+        SDL_Rect staleSrc = {0, 0, staleRect.w, staleRect.h};
+        SDL_RenderCopy(renderer, staleTexture, &staleSrc, &staleRect);
+    }
 
+    TRACE_ZONE("render.present");
     SDL_SetRenderTarget(renderer, NULL);
     SDL_RenderCopyEx(renderer, renderTexture, nullptr, &bgRect, screenAngle, nullptr, SDL_FLIP_NONE);
 
     SDL_RenderPresent(renderer);
+
+    // Only the first frame showing a sample says how long it took to appear
+    if (data.sampleTimeUs && data.sampleTimeUs != presentedSampleUs) {
+        presentedSampleUs = data.sampleTimeUs;
+        uint64_t latencyUs = monotonicMicros() - data.sampleTimeUs;
+        displayLatencyUs = displayLatencyUs ? (displayLatencyUs * 7 + latencyUs) / 8 : latencyUs;
+        TRACE_COUNTER("display.latencyUs", latencyUs);
+    }
+    return true;
 }
 
 void Renderer::renderLoadThrottleBar(float startAngle, float endAngle, SDL_Color color, bool outline) {
@@ -111,16 +280,41 @@ void Renderer::renderLoadThrottleBar(float startAngle, float endAngle, SDL_Color
     int numPoints = 100;
     int customRadius = radius + 120;
     int customInnerRadius = radius + 55;
-    std::vector<Sint16> vX(numPoints);
-    std::vector<Sint16> vY(numPoints);
     if(outline) {
-        generateArcPoints(startAngle, endAngle, customRadius, customInnerRadius, vX, vY, true);
-        polygonRGBA(renderer, vX.data(), vY.data(), numPoints, color.r, color.g, color.b, color.a);
-        filledPolygonRGBA(renderer, vX.data(), vY.data(), numPoints, barBackColor.r, barBackColor.g, barBackColor.b, barBackColor.a);
+        Sint16* vX = frameArena.allocate<Sint16>(numPoints);
+        Sint16* vY = frameArena.allocate<Sint16>(numPoints);
+        if (!vX || !vY) return;
+        generateArcPoints(startAngle, endAngle, customRadius, customInnerRadius, vX, vY, numPoints, true);
+        polygonRGBA(renderer, vX, vY, numPoints, color.r, color.g, color.b, color.a);
+        filledPolygonRGBA(renderer, vX, vY, numPoints, barBackColor.r, barBackColor.g, barBackColor.b, barBackColor.a);
     }else{
-        generateArcPoints(startAngle, endAngle, customRadius, customInnerRadius, vX, vY);
-        filledPolygonRGBA(renderer, vX.data(), vY.data(), numPoints, color.r, color.g, color.b, color.a);
+        fillArc(startAngle, endAngle, customRadius, customInnerRadius, color, numPoints);
+    }
+}
+
+void Renderer::renderArcs() {
+    TRACE_ZONE("render.arcs");
+    if (arcBackend == ArcBackend::Simd) {
+        arcRasterizer.begin();
+    }
+    float rpmRatio = smoothedRpm / RPM_MAX;
+    drawRPMArc(RPM_ARC_END_ANGLE, RPM_ARC_START_ANGLE - (RPM_ARC_START_ANGLE - RPM_ARC_END_ANGLE) * (1.0 - rpmRatio), rpmArcColor(), false);
+    renderLoadThrottleBars();
+    if (arcBackend == ArcBackend::Simd) {
+        arcRasterizer.draw(renderer);
+    }
+}
+
+void Renderer::fillArc(float startAngle, float endAngle, int outerRad, int innerRad, SDL_Color color, int numPoints) {
+    if (arcBackend == ArcBackend::Simd) {
+        arcRasterizer.fillArc(startAngle, endAngle, outerRad, innerRad, color, color);
+        return;
     }
+    Sint16* vX = frameArena.allocate<Sint16>(numPoints);
+    Sint16* vY = frameArena.allocate<Sint16>(numPoints);
+    if (!vX || !vY) return;
+    generateArcPoints(startAngle, endAngle, outerRad, innerRad, vX, vY, numPoints);
+    filledPolygonRGBA(renderer, vX, vY, numPoints, color.r, color.g, color.b, color.a);
 }
 
 static SDL_Color lerpColor(SDL_Color c1, SDL_Color c2, float t) {
@@ -152,74 +346,78 @@ void Renderer::renderLoadThrottleBars() {
 
     renderLoadThrottleBar(LOAD_ANGLE_END, LOAD_ANGLE_START + (LOAD_ANGLE_END - LOAD_ANGLE_START) * (1.0 - smoothedLoad / 100.0f), loadColor, false);
     renderLoadThrottleBar(THROTTLE_ANGLE_START, THROTTLE_ANGLE_START + (THROTTLE_ANGLE_END - THROTTLE_ANGLE_START) * smoothedThrottle / THROTTLE_MAX, {20, 20, 255, 140}, false);
+}
 
+void Renderer::renderLoadThrottleIcons() {
+    TRACE_ZONE("render.icons");
     SDL_Rect loadTextureRect = {80, height - 65, 60, 60};
     SDL_Color engineLoadColor = smoothedLoad > 80.0f ? SDL_Color{255, 255, 20, 255} : SDL_Color{255, 255, 255, 255};
-    SDL_SetTextureColorMod(engineLoadTexture, engineLoadColor.r, engineLoadColor.g, engineLoadColor.b);
-    SDL_RenderCopy(renderer, engineLoadTexture, NULL, &loadTextureRect);
+    drawIcon(ICON_LOAD, loadTextureRect, engineLoadColor);
     SDL_Rect throttleTextureRect = {width - 80 - 50, height - 60, 60, 60};
-    SDL_RenderCopy(renderer, throttleTexture, NULL, &throttleTextureRect);
+    drawIcon(ICON_THROTTLE, throttleTextureRect, {255, 255, 255, 255});
 }
 
 void Renderer::renderGear(int gear, bool goal) {
+    TRACE_ZONE("render.gear");
     if(goal && (gear == GEAR_NONE || gear == -2)){
         return;
     }
-    std::string gearText = gear == 0 ? "N" : std::to_string(gear);
-    SDL_Color outlineColor = {216, 67, 21, 255};
-    SDL_Color fillColor = {0, 0, 0, 255};
-    SDL_Surface* gearSurface = TTF_RenderText_Blended(goal ? gearGoalFont : gearFont, gearText.c_str(), {255,255,255,255});
-    SDL_Texture* gearTexture = SDL_CreateTextureFromSurface(renderer, gearSurface);
-    SDL_Rect gearRect = {
-        goal ? 250 : (width - gearSurface->w) / 2,
-        centerY - gearSurface->h / 2,
-        gearSurface->w,
-        gearSurface->h
-    };
-
-    SDL_SetTextureColorMod(gearTexture, outlineColor.r, outlineColor.g, outlineColor.b);
-    for (int dx = -2; dx <= 5; ++dx) {
-        for (int dy = -2; dy <= 5; ++dy) {
-            if (dx == 0 && dy == 0) continue;
-            SDL_Rect outlineRect = gearRect;
-            outlineRect.x += dx;
-            outlineRect.y += dy;
-            SDL_RenderCopy(renderer, gearTexture, nullptr, &outlineRect);
+    CachedWidget<int>& widget = goal ? gearGoalWidget : gearWidget;
+    if (widget.needsUpdate(gear)) {
+        FixedString<8> gearText;
+        if (gear == 0) {
+            gearText.append('N');
+        } else {
+            gearText.appendInt(gear);
         }
+        SDL_Color outlineColor = {216, 67, 21, 255};
+        SDL_Color fillColor = {0, 0, 0, 255};
+        int textW, textH;
+        SDL_Texture* gearTexture = renderOutlinedText(goal ? gearGoalFont : gearFont, gearText.c_str(), outlineColor, fillColor, -2, 5, textW, textH);
+        SDL_Rect gearRect = {
+            (goal ? 250 : (width - textW) / 2) - 2,
+            centerY - textH / 2 - 2,
+            textW + 7,
+            textH + 7
+        };
+        widget.setOutput(gearTexture, gearRect);
     }
-
-    SDL_SetTextureColorMod(gearTexture, fillColor.r, fillColor.g, fillColor.b);
-    SDL_RenderCopy(renderer, gearTexture, nullptr, &gearRect);
-    SDL_FreeSurface(gearSurface);
-    SDL_DestroyTexture(gearTexture);
+    widget.draw(renderer);
 }
 
 void Renderer::renderSpeed(float speed) {
-    std::string speedText = "--";
-    if (speed != -1.0f) {
-        int intSpeed = static_cast<int>(speed);
-        std::ostringstream speedOss;
-        speedOss.width(2);
-        speedOss.fill('0');
-        speedOss << intSpeed;
-        speedText = speedOss.str();
-    }
-
-    const SDL_Color speedColor = {255, 255, 255, 255};
-    SDL_Surface* speedSurface = TTF_RenderText_Blended(speedFont, speedText.c_str(), speedColor);
-    SDL_Texture* speedTexture = SDL_CreateTextureFromSurface(renderer, speedSurface);
-    SDL_Rect speedRect = {
-        (width - speedSurface->w) / 2,
-        centerY + speedSurface->h / 2 + 20,
-        speedSurface->w,
-        speedSurface->h
-    };
-    SDL_RenderCopyEx(renderer, speedTexture, nullptr, &speedRect, 0, nullptr, SDL_FLIP_NONE);
-    SDL_FreeSurface(speedSurface);
-    SDL_DestroyTexture(speedTexture);
+    TRACE_ZONE("render.speed");
+    int intSpeed = speed != -1.0f ? static_cast<int>(speed) : -1;
+    if (speedWidget.needsUpdate(intSpeed)) {
+        FixedString<8> speedText;
+        if (intSpeed != -1) {
+            speedText.appendInt(intSpeed, 2);
+        } else {
+            speedText.append("--");
+        }
+
+        const SDL_Color speedColor = {255, 255, 255, 255};
+        SDL_Surface* speedSurface = TTF_RenderText_Blended(speedFont, speedText.c_str(), speedColor);
+        SDL_Texture* speedTexture = textures.acquireFromSurface(TEXTURE_TEXT, speedSurface);
+        SDL_Rect speedRect = {
+            (width - speedSurface->w) / 2,
+            centerY + speedSurface->h / 2 + 20,
+            speedSurface->w,
+            speedSurface->h
+        };
+        SDL_FreeSurface(speedSurface);
+        speedWidget.setOutput(speedTexture, speedRect);
+    }
+    speedWidget.draw(renderer);
 }
 
 void Renderer::renderRPM() {
+    TRACE_ZONE("render.rpm");
+    drawRPMNumbers();
+    drawNeedle(smoothedRpm / RPM_MAX);
+}
+
+SDL_Color Renderer::rpmArcColor() {
     Uint8 a = 160;
     Uint8 minAlpha = 80;
     SDL_Color lightBlue = {20, 20, 230, a};
@@ -228,29 +426,9 @@ void Renderer::renderRPM() {
     float rpm = smoothedRpm / 1000.0f;
     SDL_Color rpmColor;
 
-    Uint32 currentTime = SDL_GetTicks();
-
-    const int alphaStep = 30;
-
-    if (smoothedRpm >= WARNING_ARC_RPM) {
-        if (currentTime - lastRpmFlashToggleTime >= rpmFlashInterval) {
-            lastRpmFlashToggleTime = currentTime;
-            if (rpmAlphaIncreasing) {
-                rpmAlpha += alphaStep;
-                if (rpmAlpha >= a) {
-                    rpmAlpha = a;
-                    rpmAlphaIncreasing = false;
-                }
-            } else {
-                rpmAlpha -= alphaStep;
-                if (rpmAlpha <= minAlpha) {
-                    rpmAlpha = minAlpha;
-                    rpmAlphaIncreasing = true;
-                }
-            }
-        }
-    } else {
-        rpmAlpha = a;
+    Uint8 rpmAlpha = a;
+    if (rpmFlashActive) {
+        rpmAlpha = a - (Uint8)((a - minAlpha) * triangleWave(lastUpdateUs - rpmFlashStartUs, rpmFlashPeriodUs));
     }
 
     if (rpm <= 6.0f) {
@@ -272,28 +450,26 @@ void Renderer::renderRPM() {
     } else {
         rpmColor.a = a;
     }
-
-    float rpmRatio = smoothedRpm / RPM_MAX;
-    drawRPMArc(RPM_ARC_END_ANGLE, RPM_ARC_START_ANGLE - (RPM_ARC_START_ANGLE - RPM_ARC_END_ANGLE) * (1.0 - rpmRatio), rpmColor, false);
-    drawRPMNumbers();
-    drawNeedle(rpmRatio);
+    return rpmColor;
 }
 
 void Renderer::drawRPMArc(float startAngle, float endAngle, SDL_Color color, bool ticks) {
     int numPoints = 120;
     float angleRange = startAngle - endAngle;
 
-    std::vector<Sint16> vX(numPoints);
-    std::vector<Sint16> vY(numPoints);
-    generateArcPoints(startAngle, endAngle, radius, innerRadius, vX, vY, ticks);
-
-    filledPolygonRGBA(renderer, vX.data(), vY.data(), numPoints, color.r, color.g, color.b, color.a);
-
     if (!ticks){
+        fillArc(startAngle, endAngle, radius, innerRadius, color, numPoints);
         return;
     }
 
-    polygonRGBA(renderer, vX.data(), vY.data(), numPoints, 255, 255, 255, 200);
+    Sint16* vX = frameArena.allocate<Sint16>(numPoints);
+    Sint16* vY = frameArena.allocate<Sint16>(numPoints);
+    if (!vX || !vY) return;
+    generateArcPoints(startAngle, endAngle, radius, innerRadius, vX, vY, numPoints, ticks);
+
+    filledPolygonRGBA(renderer, vX, vY, numPoints, color.r, color.g, color.b, color.a);
+
+    polygonRGBA(renderer, vX, vY, numPoints, 255, 255, 255, 200);
 
     int numTicks = 24;
     int tickLength = 18;
@@ -319,7 +495,7 @@ void Renderer::drawRPMArc(float startAngle, float endAngle, SDL_Color color, boo
     }
 }
 
-void Renderer::drawRPMNumbers() {
+void Renderer::preRenderNumbers() {
     const int numNumbers = 12;
     const float angleStep = (RPM_ARC_END_ANGLE - RPM_ARC_START_ANGLE) / numNumbers;
     const int numberRadius = innerRadius + (radius - innerRadius) / 2.7;
@@ -329,7 +505,8 @@ void Renderer::drawRPMNumbers() {
         float angleRad = angle * M_PI / 180.0f;
         int x = centerX - numberRadius * cosf(angleRad);
         int y = centerY + numberRadius * sinf(angleRad);
-        std::string numberText = std::to_string(i);
+        FixedString<4> numberText;
+        numberText.appendInt(i);
         SDL_Color numberColor;
 
         if (i == 11 || i == 12) {
@@ -338,26 +515,54 @@ void Renderer::drawRPMNumbers() {
             numberColor = {255, 255, 255, 255};
         }
 
-        SDL_Surface* numberSurface = TTF_RenderText_Blended(numberFont, numberText.c_str(), numberColor);
-        SDL_Texture* numberTexture = SDL_CreateTextureFromSurface(renderer, numberSurface);
-        SDL_Rect numberRect = {x - numberSurface->w / 2 + 2, y - numberSurface->h / 2 + 8, numberSurface->w, numberSurface->h};
         SDL_Color outlineColor = {0, 0, 0, 255};
-        SDL_SetTextureColorMod(numberTexture, outlineColor.r, outlineColor.g, outlineColor.b);
-
-        for (int offsetX = -2; offsetX <= 2; ++offsetX) {
-            for (int offsetY = -2; offsetY <= 2; ++offsetY) {
-                SDL_Rect outlineRect = numberRect;
-                outlineRect.x += offsetX;
-                outlineRect.y += offsetY;
-                SDL_RenderCopy(renderer, numberTexture, NULL, &outlineRect);
-            }
-        }
+        int textW, textH;
+        numberTextures[i] = renderOutlinedText(numberFont, numberText.c_str(), outlineColor, numberColor, -2, 2, textW, textH);
+        numberRects[i] = {x - textW / 2, y - textH / 2 + 6, textW + 4, textH + 4};
+    }
+}
+
+void Renderer::drawRPMNumbers() {
+    for (int i = 0; i < RPM_NUMBER_COUNT; ++i) {
+        SDL_Rect src = {0, 0, numberRects[i].w, numberRects[i].h};
+        SDL_RenderCopy(renderer, numberTextures[i], &src, &numberRects[i]);
+    }
+}
+
+SDL_Texture* Renderer::renderOutlinedText(TTF_Font* font, const char* text, SDL_Color outlineColor, SDL_Color fillColor, int outlineMin, int outlineMax, int& textW, int& textH) {
+    SDL_Surface* textSurface = TTF_RenderText_Blended(font, text, {255, 255, 255, 255});
+    SDL_Texture* textTexture = textures.acquireFromSurface(TEXTURE_GLYPH, textSurface);
+    textW = textSurface->w;
+    textH = textSurface->h;
+    SDL_FreeSurface(textSurface);
+
+    // The result extends from outlineMin to outlineMax around the glyphs
+    int padding = outlineMax - outlineMin;
+    SDL_Rect textSrc = {0, 0, textW, textH};
+    SDL_Rect glyphRect = {-outlineMin, -outlineMin, textW, textH};
+    SDL_Texture* outlinedTexture = textures.acquire(TEXTURE_TEXT, textures.getNativeFormat(), SDL_TEXTUREACCESS_TARGET, textW + padding, textH + padding);
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, outlinedTexture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
 
-        SDL_SetTextureColorMod(numberTexture, numberColor.r, numberColor.g, numberColor.b);
-        SDL_RenderCopy(renderer, numberTexture, NULL, &numberRect);
-        SDL_FreeSurface(numberSurface);
-        SDL_DestroyTexture(numberTexture);
+    SDL_SetTextureColorMod(textTexture, outlineColor.r, outlineColor.g, outlineColor.b);
+    for (int dx = outlineMin; dx <= outlineMax; ++dx) {
+        for (int dy = outlineMin; dy <= outlineMax; ++dy) {
+            if (dx == 0 && dy == 0) continue;
+            SDL_Rect outlineRect = glyphRect;
+            outlineRect.x += dx;
+            outlineRect.y += dy;
+            SDL_RenderCopy(renderer, textTexture, &textSrc, &outlineRect);
+        }
     }
+    SDL_SetTextureColorMod(textTexture, fillColor.r, fillColor.g, fillColor.b);
+    SDL_RenderCopy(renderer, textTexture, &textSrc, &glyphRect);
+
+    SDL_SetRenderTarget(renderer, previousTarget);
+    textures.release(textTexture);
+    textures.finishComposed(outlinedTexture);
+    return outlinedTexture;
 }
 
 void Renderer::drawNeedle(float rpmRatio) {
@@ -371,79 +576,97 @@ void Renderer::drawNeedle(float rpmRatio) {
     thickLineRGBA(renderer, startX, startY, endX, endY, 3, needleColor.r, needleColor.g, needleColor.b, needleColor.a);
 }
 
-SDL_Texture* Renderer::loadTexture(const std::string& filePath) {
-    SDL_Texture* texture = IMG_LoadTexture(renderer, filePath.c_str());
+// The vertex color multiplies every channel, a translucent tint has to be
+// premultiplied as well to stay consistent with the atlas
+void Renderer::drawIcon(int icon, const SDL_Rect& dst, SDL_Color color) {
+    if (textures.isPremultiplied() && color.a != 255) {
+        color.r = (Uint8)(color.r * color.a / 255);
+        color.g = (Uint8)(color.g * color.a / 255);
+        color.b = (Uint8)(color.b * color.a / 255);
+    }
+    drawQueue.push(iconAtlas.getTexture(), textures.getAlphaBlendMode(), iconAtlas.getRect(icon), dst, color);
+}
 
-    if (!texture) {
-        std::cerr << "IMG_LoadTexture Error: " << IMG_GetError() << std::endl;
+// The background is only ever drawn stretched to the screen, so it is scaled
+// down once on the CPU instead of keeping the full size image on the GPU.
+SDL_Texture* Renderer::loadBackground(const std::string& filePath) {
+    SDL_Surface* loaded = IMG_Load(filePath.c_str());
+    if (!loaded) {
+        std::cerr << "IMG_Load Error: " << IMG_GetError() << std::endl;
+        return nullptr;
+    }
+    SDL_Surface* image = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loaded);
+    if (!image) {
+        std::cerr << "SDL_ConvertSurfaceFormat Error: " << SDL_GetError() << std::endl;
+        return nullptr;
     }
+    SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_SoftStretchLinear(image, NULL, scaled, NULL);
+    SDL_FreeSurface(image);
 
+    SDL_Texture* texture = textures.acquireStatic(TEXTURE_BACKGROUND, scaled, true);
+    SDL_FreeSurface(scaled);
     return texture;
 }
 
 void Renderer::renderInfoTexts(float ambientTemp, float coolantTemp, float batteryVoltage, bool clutchPressed) {
-    auto renderIcon = [&](SDL_Texture* iconTexture, int x, int y, int size){
+    TRACE_ZONE("render.info");
+    auto renderIcon = [&](int icon, int x, int y, int size, SDL_Color color){
         SDL_Rect iconRect = {x, y, size, size};
-        SDL_RenderCopy(renderer, iconTexture, NULL, &iconRect);
+        drawIcon(icon, iconRect, color);
     };
-    auto renderInfoTextWithIcon = [&](SDL_Texture* iconTexture, int x, int y, float value, const std::string& label, const SDL_Color& color) {
+    auto renderInfoTextWithIcon = [&](int icon, SDL_Color iconColor, CachedWidget<int>& widget, int x, int y, int tenths, const char* label, const SDL_Color& color) {
         int iconSize = 32;
-        renderIcon(iconTexture, x, y, iconSize);
-        std::stringstream ss;
-        ss << std::fixed << std::setprecision(1) << value << " " << label;
-        std::string text = ss.str();
-        SDL_Surface* textSurface = TTF_RenderText_Blended(infoFont, text.c_str(), color);
-        SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-        SDL_Rect textRect = {x + iconSize + 5, y + (iconSize - textSurface->h) / 2, textSurface->w, textSurface->h};
-        SDL_RenderCopy(renderer, textTexture, NULL, &textRect);
-        SDL_FreeSurface(textSurface);
-        SDL_DestroyTexture(textTexture);
+        renderIcon(icon, x, y, iconSize, iconColor);
+        if (widget.needsUpdate(tenths)) {
+            FixedString<24> text;
+            text.appendFixed(tenths, 1).append(' ').append(label);
+            SDL_Surface* textSurface = TTF_RenderText_Blended(infoFont, text.c_str(), color);
+            SDL_Texture* textTexture = textures.acquireFromSurface(TEXTURE_TEXT, textSurface);
+            SDL_Rect textRect = {x + iconSize + 5, y + (iconSize - textSurface->h) / 2, textSurface->w, textSurface->h};
+            SDL_FreeSurface(textSurface);
+            widget.setOutput(textTexture, textRect);
+        }
+        widget.draw(renderer);
     };
     int iconSize = 32;
     int x = 40;
     int y = 20;
     int yOffset = iconSize + 10;
 
+    int batteryTenths = (int)lroundf(batteryVoltage * 10.0f);
     SDL_Color batteryColor =
-            (batteryVoltage < 11.0) ? SDL_Color{255, 20, 20, 255} :
-            (batteryVoltage < 12.0) ? SDL_Color{255, 255, 20, 255} :
+            (batteryTenths < 110) ? SDL_Color{255, 20, 20, 255} :
+            (batteryTenths < 120) ? SDL_Color{255, 255, 20, 255} :
             SDL_Color{20, 255, 20, 255};
-    SDL_SetTextureColorMod(batteryTexture, batteryColor.r, batteryColor.g, batteryColor.b);
-    renderInfoTextWithIcon(batteryTexture, width - 160, y, batteryVoltage, "V", batteryColor);
+    renderInfoTextWithIcon(ICON_BATTERY, batteryColor, batteryWidget, width - 160, y, batteryTenths, "V", batteryColor);
 
-    renderInfoTextWithIcon(tempTexture, x, y, ambientTemp, "C", SDL_Color{255, 255, 255, 255});
+    renderInfoTextWithIcon(ICON_TEMP, SDL_Color{255, 255, 255, 255}, ambientWidget, x, y, (int)lroundf(ambientTemp * 10.0f), "C", SDL_Color{255, 255, 255, 255});
 
     y += yOffset;
 
+    int coolantTenths = (int)lroundf(coolantTemp * 10.0f);
     SDL_Color coolantTempColor =
-            (coolantTemp > 100.0f) ? SDL_Color{255, 20, 20, 255} :
-            (coolantTemp > 85.0f) ? SDL_Color{255, 255, 20, 255} :
+            (coolantTenths > 1000) ? SDL_Color{255, 20, 20, 255} :
+            (coolantTenths > 850) ? SDL_Color{255, 255, 20, 255} :
             SDL_Color{20, 255, 20, 255};
-    SDL_SetTextureColorMod(coolantTexture, coolantTempColor.r, coolantTempColor.g, coolantTempColor.b);
-    renderInfoTextWithIcon(coolantTexture, x, y, coolantTemp, "C", coolantTempColor);
+    renderInfoTextWithIcon(ICON_COOLANT, coolantTempColor, coolantWidget, x, y, coolantTenths, "C", coolantTempColor);
 
     SDL_Color clutchColor = clutchPressed ? SDL_Color{20, 255, 20, 255} : SDL_Color{255, 255, 255, 255};
-    SDL_SetTextureColorMod(clutchTexture, clutchColor.r, clutchColor.g, clutchColor.b);
-    renderIcon(clutchTexture, width - 164, y, 40);
-
-    if (smoothedRpm >= WARNING_LIGHTS_RPM) {
-        Uint32 currentTime = SDL_GetTicks();
-        if (currentTime - lastWarningToggleTime >= warningBlinkInterval) {
-            warningLightVisible = !warningLightVisible;
-            lastWarningToggleTime = currentTime;
-        }
+    renderIcon(ICON_CLUTCH, width - 164, y, 40, clutchColor);
 
+    if (warningActive) {
+        bool warningLightVisible = (lastUpdateUs - warningStartUs) / warningBlinkIntervalUs % 2 == 0;
         if (warningLightVisible) {
             SDL_Color warningColor = {255, 255, 20, 255};
-            SDL_SetTextureColorMod(absTexture, warningColor.r, warningColor.g, warningColor.b);
-            renderIcon(absTexture, width / 2 - 80, height - 66, 80);
-            SDL_SetTextureColorMod(tcTexture, warningColor.r, warningColor.g, warningColor.b);
-            renderIcon(tcTexture, width / 2 + 20, height - 46, 42);
+            renderIcon(ICON_ABS, width / 2 - 80, height - 66, 80, warningColor);
+            renderIcon(ICON_TC, width / 2 + 20, height - 46, 42, warningColor);
         }
     }
 }
 
-void Renderer::generateArcPoints(float startAngle, float endAngle, int outerRad, int innerRad, std::vector<Sint16>& vX, std::vector<Sint16>& vY, bool outline) const{
+void Renderer::generateArcPoints(float startAngle, float endAngle, int outerRad, int innerRad, Sint16* vX, Sint16* vY, int count, bool outline) const{
     auto arcOffsetAngle = [&](float radius, float offset) {
         if (offset >= radius) return 90.0f;
         return asinf(offset / radius) * 180.0f / (float)M_PI;
@@ -457,7 +680,7 @@ void Renderer::generateArcPoints(float startAngle, float endAngle, int outerRad,
     float newEndAngle   = endAngle   + angleOffset;
 
     float angleRange = newStartAngle - newEndAngle;
-    int numPoints = (int)vX.size() / 2;
+    int numPoints = count / 2;
 
     for (int i = 0; i < numPoints; ++i) {
         float angle = newStartAngle - ((float)i / (float)(numPoints - 1)) * angleRange;
@@ -5,6 +5,14 @@
 #include <SDL2/SDL_ttf.h>
 #include <vector>
 #include "VehicleConstants.h"
+#include "ArcRasterizer.h"
+#include "Widget.h"
+#include "Animation.h"
+#include "SpriteAtlas.h"
+#include "DrawQueue.h"
+#include "TextureManager.h"
+#include "FrameArena.h"
+#include <array>
 
 #if IS_RASPI
 #define ASSET_PATH "assets/"
@@ -18,28 +26,65 @@ const float THROTTLE_ANGLE_START = 155.0f;
 const float THROTTLE_ANGLE_END = 200.0f;
 const float LOAD_ANGLE_START = -20.0f;
 const float LOAD_ANGLE_END = 25.0f;
+const int RPM_NUMBER_COUNT = 13;
+
+enum class ArcBackend { Gfx, Simd };
+
+enum Icon {
+    ICON_TEMP,
+    ICON_COOLANT,
+    ICON_LOAD,
+    ICON_BATTERY,
+    ICON_THROTTLE,
+    ICON_CLUTCH,
+    ICON_ABS,
+    ICON_TC
+};
 
 class Renderer {
 public:
     Renderer(int width, int height);
     ~Renderer();
     void start();
-    void render(const VehicleData& data, float speed);
+    bool render(const VehicleData& data, float speed, uint64_t nowUs);
+    void update(const VehicleData& data, uint64_t nowUs);
+    bool isAnimating() const;
+    uint64_t getNextFrameUs() const;
+    float getNeedleRpm() const { return smoothedRpm; }
+    void setArcBackend(ArcBackend backend);
+    void benchmarkArcs(int frames);
+    // The last rendered frame, unrotated, as a BMP
+    bool saveFrame(const std::string& path);
+    std::vector<WidgetStats> getWidgetStats() const;
+    DrawStats getDrawStats() const { return drawQueue.getStats(); }
+    void setTextureBudget(size_t bytes);
+    TextureStats getTextureStats() const { return textures.getStats(); }
+    void setHeadless(bool headless) { this->headless = headless; }
+    size_t getFrameArenaHighWater() const { return frameArena.getHighWater(); }
+    // Parse to present of new samples, 0 until a sample was shown
+    uint64_t getDisplayLatencyUs() const { return displayLatencyUs; }
 private:
+    void renderArcs();
+    void fillArc(float startAngle, float endAngle, int outerRad, int innerRad, SDL_Color color, int numPoints);
+    SDL_Color rpmArcColor();
     void renderGear(int gear, bool goal = false);
     void renderSpeed(float speed);
     void renderRPM();
     void drawNeedle(float rpmRatio);
     void drawRPMArc(float startAngle, float endAngle, SDL_Color color, bool ticks);
     void drawRPMNumbers();
+    void preRenderNumbers();
+    SDL_Texture* renderOutlinedText(TTF_Font* font, const char* text, SDL_Color outlineColor, SDL_Color fillColor, int outlineMin, int outlineMax, int& textW, int& textH);
     void renderLoadThrottleBars();
+    void renderLoadThrottleIcons();
     void renderInfoTexts(float ambientTemp, float coolantTemp, float batteryVoltage, bool clutchPressed);
     void renderTrackText();
-    void generateArcPoints(float startAngle, float endAngle, int outerRad, int innerRad, std::vector<Sint16>& vX, std::vector<Sint16>& vY, bool outline = false) const;
+    void generateArcPoints(float startAngle, float endAngle, int outerRad, int innerRad, Sint16* vX, Sint16* vY, int count, bool outline = false) const;
     void preRenderBackground();
     void renderLoadThrottleBarBackground();
     void renderLoadThrottleBar(float startAngle, float endAngle, SDL_Color color, bool outline);
-    SDL_Texture* loadTexture(const std::string& filePath);
+    SDL_Texture* loadBackground(const std::string& filePath);
+    void drawIcon(int icon, const SDL_Rect& dst, SDL_Color color);
     SDL_Window* window;
     SDL_Renderer* renderer;
     TTF_Font* gearFont;
@@ -48,18 +93,28 @@ private:
     TTF_Font* numberFont;
     TTF_Font* trackFont;
     TTF_Font* infoFont;
+    TextureManager textures;
+    size_t textureBudget = TEXTURE_BUDGET_BYTES;
+    bool headless = false;
     SDL_Texture* bgTexture;
-    SDL_Texture* tempTexture;
-    SDL_Texture* coolantTexture;
-    SDL_Texture* engineLoadTexture;
-    SDL_Texture* batteryTexture;
-    SDL_Texture* throttleTexture;
-    SDL_Texture* clutchTexture;
-    SDL_Texture* absTexture;
-    SDL_Texture* tcTexture;
+    SpriteAtlas iconAtlas;
+    DrawQueue drawQueue;
+    FrameArena frameArena;
     SDL_Texture* renderedBackgroundTexture;
     SDL_Texture* renderTexture;
+    SDL_Texture* staleTexture;
+    SDL_Rect staleRect;
     SDL_Rect bgRect;
+    ArcRasterizer arcRasterizer;
+    ArcBackend arcBackend = ArcBackend::Gfx;
+    SDL_Texture* numberTextures[RPM_NUMBER_COUNT];
+    SDL_Rect numberRects[RPM_NUMBER_COUNT];
+    CachedWidget<int> gearWidget{"gear", textures};
+    CachedWidget<int> gearGoalWidget{"gearGoal", textures};
+    CachedWidget<int> speedWidget{"speed", textures};
+    CachedWidget<int> batteryWidget{"battery", textures};
+    CachedWidget<int> ambientWidget{"ambient", textures};
+    CachedWidget<int> coolantWidget{"coolant", textures};
     double screenAngle;
     int width, height;
     int centerX, centerY;
@@ -67,12 +122,27 @@ private:
     float smoothedRpm = 0.0f;
     float smoothedLoad = 0.0f;
     float smoothedThrottle = 0.0f;
-    const float smoothingFactor = 0.7f;
-    Uint32 lastWarningToggleTime = 0;
-    bool warningLightVisible = true;
-    const Uint32 warningBlinkInterval = 200;
-    Uint32 lastRpmFlashToggleTime = 0;
-    bool rpmAlphaIncreasing = true;
-    int rpmAlpha = 160;
-    const Uint32 rpmFlashInterval = 50;
+    float rpmTarget = 0.0f;
+    float loadTarget = 0.0f;
+    float throttleTarget = 0.0f;
+    DampedValue rpmFilter{NEEDLE_OMEGA};
+    DampedValue loadFilter{BAR_OMEGA};
+    DampedValue throttleFilter{BAR_OMEGA};
+    SampleTrack rpmTrack{MAX_SAMPLE_EXTRAPOLATION_US};
+    SampleTrack loadTrack{MAX_SAMPLE_EXTRAPOLATION_US};
+    SampleTrack throttleTrack{MAX_SAMPLE_EXTRAPOLATION_US};
+    uint64_t lastSampleTimeUs = 0;
+    uint64_t lastUpdateUs = 0;
+    bool warningActive = false;
+    uint64_t warningStartUs = 0;
+    const uint64_t warningBlinkIntervalUs = 200000;
+    bool rpmFlashActive = false;
+    uint64_t rpmFlashStartUs = 0;
+    const uint64_t rpmFlashPeriodUs = 266000;
+    std::array<int, 8> lastFrameKey{};
+    uint64_t lastFrameUs = 0;
+    uint64_t presentedSampleUs = 0;
+    uint64_t displayLatencyUs = 0;
+    const uint64_t activeFrameIntervalUs = 16667;
+    const uint64_t idleFrameIntervalUs = 250000;
 };
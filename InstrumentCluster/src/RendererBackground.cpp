@@ -1,11 +1,9 @@
 #include "Renderer.h"
 #include <SDL2_gfxPrimitives.h>
-#include <iostream>
 
 void Renderer::preRenderBackground(){
-    renderedBackgroundTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    renderedBackgroundTexture = textures.acquire(TEXTURE_TARGET, textures.getNativeFormat(), SDL_TEXTUREACCESS_TARGET, width, height);
     if (!renderedBackgroundTexture) {
-        std::cerr << "Failed to create background texture: " << SDL_GetError() << std::endl;
         return;
     }
     SDL_SetRenderTarget(renderer, renderedBackgroundTexture);
@@ -21,6 +19,10 @@ void Renderer::preRenderBackground(){
     renderTrackText();
 
     SDL_SetRenderTarget(renderer, NULL);
+
+    // The source image is baked in now
+    textures.release(bgTexture);
+    bgTexture = nullptr;
 }
 
 void Renderer::renderLoadThrottleBarBackground(){
@@ -61,7 +63,8 @@ void Renderer::renderTrackText(){
     SDL_Color outlineColor = {216, 67, 21, 255};
     SDL_Color fillColor = {0, 0, 0, 255};
     SDL_Surface* gearSurface = TTF_RenderText_Blended(trackFont, "TRACK", {255,255,255,255});
-    SDL_Texture* gearTexture = SDL_CreateTextureFromSurface(renderer, gearSurface);
+    SDL_Texture* gearTexture = textures.acquireFromSurface(TEXTURE_GLYPH, gearSurface);
+    SDL_Rect gearSrc = {0, 0, gearSurface->w, gearSurface->h};
     SDL_Rect gearRect = {
             (width - gearSurface->w) / 2 + 90,
             centerY - gearSurface->h / 2 + 84,
@@ -76,12 +79,12 @@ void Renderer::renderTrackText(){
             SDL_Rect outlineRect = gearRect;
             outlineRect.x += dx;
             outlineRect.y += dy;
-            SDL_RenderCopy(renderer, gearTexture, nullptr, &outlineRect);
+            SDL_RenderCopy(renderer, gearTexture, &gearSrc, &outlineRect);
         }
     }
 
     SDL_SetTextureColorMod(gearTexture, fillColor.r, fillColor.g, fillColor.b);
-    SDL_RenderCopy(renderer, gearTexture, nullptr, &gearRect);
+    SDL_RenderCopy(renderer, gearTexture, &gearSrc, &gearRect);
     SDL_FreeSurface(gearSurface);
-    SDL_DestroyTexture(gearTexture);
+    textures.release(gearTexture);
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "Scheduling.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+// Touches every page of a stack frame so later calls do not fault it in
+void prefaultStack() {
+    unsigned char stack[PREFAULT_STACK_BYTES];
+    memset(stack, 0, sizeof(stack));
+    __asm__ __volatile__("" : : "r"(stack) : "memory");
+}
+
+int64_t toNs(const timespec& time) {
+    return (int64_t)time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+}
+
+int64_t JitterStats::percentileUs(double percentile) const {
+    uint64_t target = (uint64_t)(samples * percentile / 100.0);
+    uint64_t seen = 0;
+    for (int i = 0; i < JITTER_HISTOGRAM_US; ++i) {
+        seen += histogram[i];
+        if (seen > target) return i;
+    }
+    return maxUs;
+}
+
+SchedulingProfile Scheduling::realtimeProfile() {
+    SchedulingProfile profile;
+    profile.main = {SCHED_CORE_MAIN, SCHED_PRIORITY_MAIN};
+    profile.serial = {SCHED_CORE_SERIAL, SCHED_PRIORITY_SERIAL};
+    profile.lockMemory = true;
+    return profile;
+}
+
+bool Scheduling::applyToCurrentThread(const ThreadProfile& profile, const char* name) {
+    bool ok = true;
+    if (profile.core >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(profile.core, &cpus);
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (result != 0) {
+            std::cerr << "Scheduling: cannot pin " << name << " to core " << profile.core << ": " << strerror(result) << std::endl;
+            ok = false;
+        }
+    }
+    if (profile.priority > 0) {
+        sched_param param = {};
+        param.sched_priority = profile.priority;
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0) {
+            std::cerr << "Scheduling: cannot run " << name << " SCHED_FIFO " << profile.priority << ": " << strerror(result) << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// Freed heap is kept instead of trimmed or unmapped, so the prefaulted pages
+// stay resident and later allocations do not fault
+bool Scheduling::lockMemory() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        std::cerr << "Scheduling: mlockall failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    char* heap = (char*)malloc(PREFAULT_HEAP_BYTES);
+    if (heap) {
+        long page = sysconf(_SC_PAGESIZE);
+        for (size_t i = 0; i < PREFAULT_HEAP_BYTES; i += page) {
+            heap[i] = 0;
+        }
+        free(heap);
+    }
+    prefaultStack();
+    return true;
+}
+
+// cyclictest style: sleep to absolute deadlines and record how late the
+// thread woke up. Nothing in the loop allocates or takes a lock.
+void Scheduling::measureJitter(const ThreadProfile& profile, const char* name, int seconds, JitterStats& stats) {
+    applyToCurrentThread(profile, name);
+    stats = JitterStats();
+    stats.minUs = INT64_MAX;
+    int64_t totalNs = 0;
+    uint64_t loops = (uint64_t)seconds * 1000000 / JITTER_INTERVAL_US;
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (uint64_t i = 0; i < loops; ++i) {
+        next.tv_nsec += JITTER_INTERVAL_US * 1000;
+        while (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t latencyNs = std::max<int64_t>(0, toNs(now) - toNs(next));
+        int64_t latencyUs = latencyNs / 1000;
+        totalNs += latencyNs;
+        stats.minUs = std::min(stats.minUs, latencyUs);
+        stats.maxUs = std::max(stats.maxUs, latencyUs);
+        if (latencyUs < JITTER_HISTOGRAM_US) {
+            stats.histogram[latencyUs]++;
+        } else {
+            stats.overflows++;
+        }
+        stats.samples++;
+    }
+    if (stats.samples > 0) {
+        stats.avgUs = totalNs / 1000.0 / stats.samples;
+    } else {
+        stats.minUs = 0;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Cores 2 and 3 are taken out of the general scheduler by isolcpus in the
+// board cmdline.txt, everything else (SDL/GL driver threads, kernel work)
+// stays on 0 and 1. The serial thread ranks above the render loop so a frame
+// never delays a CAN sample or a shift report.
+const int SCHED_CORE_MAIN = 2;
+const int SCHED_CORE_SERIAL = 3;
+const int SCHED_PRIORITY_MAIN = 60;
+const int SCHED_PRIORITY_SERIAL = 70;
+const size_t PREFAULT_STACK_BYTES = 512 * 1024;
+const size_t PREFAULT_HEAP_BYTES = 16 * 1024 * 1024;
+
+const int JITTER_INTERVAL_US = 1000;
+const int JITTER_HISTOGRAM_US = 1000;
+
+// core < 0 leaves the affinity alone, priority 0 keeps SCHED_OTHER
+struct ThreadProfile {
+    int core = -1;
+    int priority = 0;
+};
+
+struct SchedulingProfile {
+    ThreadProfile main;
+    ThreadProfile serial;
+    bool lockMemory = false;
+};
+
+// Wake-up latency of a periodic thread, one microsecond per histogram bucket
+struct JitterStats {
+    uint64_t samples = 0;
+    uint64_t overflows = 0;
+    int64_t minUs = 0;
+    int64_t maxUs = 0;
+    double avgUs = 0.0;
+    std::array<uint32_t, JITTER_HISTOGRAM_US> histogram{};
+
+    int64_t percentileUs(double percentile) const;
+};
+
+// Failures (no CAP_SYS_NICE, missing core) are reported on std::cerr and
+// leave the thread as it was, the cluster keeps running either way.
+namespace Scheduling {
+    SchedulingProfile realtimeProfile();
+    bool applyToCurrentThread(const ThreadProfile& profile, const char* name);
+    bool lockMemory();
+    void measureJitter(const ThreadProfile& profile, const char* name, int seconds, JitterStats& stats);
+}
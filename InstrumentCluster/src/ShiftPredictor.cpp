@@ -0,0 +1,106 @@
+#include "ShiftPredictor.h"
+#include <algorithm>
+
+ShiftPredictor::ShiftPredictor() {
+    std::fill(times, times + SHIFT_PREDICTION_WINDOW, 0);
+    std::fill(rpms, rpms + SHIFT_PREDICTION_WINDOW, 0.0f);
+}
+
+float ShiftPredictor::gearRateScale(int gear) {
+    if (gear < GEAR_1 || gear > (int)GEAR_RATIOS.size()) return 0.0f;
+    float ratio = GEAR_RATIOS[gear - 1] / GEAR_RATIOS[0];
+    return ratio * ratio;
+}
+
+float ShiftPredictor::getExpectedRpmRate(int forGear) const {
+    return firstGearRate * gearRateScale(forGear);
+}
+
+uint64_t ShiftPredictor::getLeadTimeUs() const {
+    // On average a sample is already half an interval old when the next one arrives
+    return displayLatencyUs + SERIAL_LINE_LATENCY_US + (uint64_t)(meanIntervalUs / 2.0f);
+}
+
+void ShiftPredictor::addSample(uint64_t timeUs, int rpm, int sampleGear) {
+    if (count > 0) {
+        uint64_t lastTime = times[(head + SHIFT_PREDICTION_WINDOW - 1) % SHIFT_PREDICTION_WINDOW];
+        if (timeUs <= lastTime) {
+            return;
+        }
+        float interval = (float)(timeUs - lastTime);
+        meanIntervalUs = meanIntervalUs == 0.0f ? interval : meanIntervalUs * 0.9f + interval * 0.1f;
+    }
+    // A gear change makes the RPM jump, the old samples say nothing about the new slope
+    if (sampleGear != gear) {
+        gear = sampleGear;
+        count = 0;
+    }
+
+    times[head] = timeUs;
+    rpms[head] = (float)rpm;
+    head = (head + 1) % SHIFT_PREDICTION_WINDOW;
+    count = std::min(count + 1, SHIFT_PREDICTION_WINDOW);
+
+    int fitted = fitSlope();
+    float scale = gearRateScale(gear);
+    if (fitted >= SHIFT_PREDICTION_MIN_FIT) {
+        if (rpmRate > 0.0f && scale > 0.0f) {
+            float rate = std::min(rpmRate / scale, MAX_FIRST_GEAR_RPM_RATE);
+            firstGearRate = firstGearRate == 0.0f ? rate : firstGearRate * 0.8f + rate * 0.2f;
+        }
+    } else if (firstGearRate > 0.0f && scale > 0.0f) {
+        float weight = (float)fitted / SHIFT_PREDICTION_MIN_FIT;
+        rpmRate = weight * rpmRate + (1.0f - weight) * getExpectedRpmRate(gear);
+    }
+    predictedRpm = fittedRpm + rpmRate * (float)getLeadTimeUs() / 1e6f;
+
+    bool canShiftUp = gear >= GEAR_1 && gear < GEAR_6;
+    if (!canShiftUp) {
+        shiftLight = false;
+    } else if (predictedRpm >= WARNING_LIGHTS_RPM) {
+        shiftLight = true;
+    } else if (predictedRpm < WARNING_LIGHTS_RPM - SHIFT_LIGHT_HYSTERESIS_RPM) {
+        shiftLight = false;
+    }
+    overRev = predictedRpm >= WARNING_ARC_RPM;
+}
+
+// Returns how many samples went into the fit
+int ShiftPredictor::fitSlope() {
+    int newest = (head + SHIFT_PREDICTION_WINDOW - 1) % SHIFT_PREDICTION_WINDOW;
+    uint64_t newestTime = times[newest];
+
+    // Times relative to the newest sample keep the sums small in float
+    float sumT = 0.0f, sumR = 0.0f;
+    int n = 0;
+    for (int i = 0; i < count; ++i) {
+        int index = (newest + SHIFT_PREDICTION_WINDOW - i) % SHIFT_PREDICTION_WINDOW;
+        if (newestTime - times[index] > SHIFT_PREDICTION_SPAN_US) break;
+        sumT += -(float)(newestTime - times[index]) / 1e6f;
+        sumR += rpms[index];
+        n++;
+    }
+    if (n < 2) {
+        rpmRate = 0.0f;
+        fittedRpm = rpms[newest];
+        return n;
+    }
+
+    float meanT = sumT / n;
+    float meanR = sumR / n;
+    float covariance = 0.0f, variance = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        int index = (newest + SHIFT_PREDICTION_WINDOW - i) % SHIFT_PREDICTION_WINDOW;
+        float dt = -(float)(newestTime - times[index]) / 1e6f - meanT;
+        covariance += dt * (rpms[index] - meanR);
+        variance += dt * dt;
+    }
+    rpmRate = variance > 0.0f ? covariance / variance : 0.0f;
+
+    // Faster than the car can accelerate in this gear is noise, not a trend
+    float gearRatio = gear >= GEAR_1 && gear <= (int)GEAR_RATIOS.size() ? GEAR_RATIOS[gear - 1] : GEAR_RATIOS[0];
+    float maxRate = MAX_FIRST_GEAR_RPM_RATE * gearRatio / GEAR_RATIOS[0];
+    rpmRate = std::max(-maxRate, std::min(maxRate, rpmRate));
+    fittedRpm = meanR - rpmRate * meanT;
+    return n;
+}
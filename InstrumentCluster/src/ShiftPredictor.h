@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include "VehicleConstants.h"
+
+const int SHIFT_PREDICTION_WINDOW = 8;
+const uint64_t SHIFT_PREDICTION_SPAN_US = 300000;
+const uint64_t DISPLAY_LATENCY_US = 35000;       // parse to present until the renderer measured it
+const uint64_t SERIAL_LINE_LATENCY_US = 5500;    // ~60 byte telemetry line at 115200 baud
+const float MAX_FIRST_GEAR_RPM_RATE = 20000.0f;  // rpm/s, scaled down by the ratio of higher gears
+const int SHIFT_LIGHT_HYSTERESIS_RPM = 200;
+const int SHIFT_PREDICTION_MIN_FIT = 4;          // samples in a gear before the fit alone is trusted
+
+// Predicts where the engine RPM will be by the time the driver sees the
+// cluster. The RPM slope is a least-squares fit over the last few timestamped
+// samples of the current gear; the light fires when the extrapolated RPM
+// reaches the threshold. Right after a gear change the window is short, so
+// the slope leans on the acceleration learned in earlier pulls, scaled to the
+// gear by the square of its ratio (torque at the wheel times RPM per speed).
+// Fixed-size state only, safe to run per sample in the serial thread.
+class ShiftPredictor {
+public:
+    ShiftPredictor();
+    void addSample(uint64_t timeUs, int rpm, int gear);
+    void setDisplayLatency(uint64_t latencyUs) { displayLatencyUs = latencyUs; }
+    uint64_t getLeadTimeUs() const;
+    float getRpmRate() const { return rpmRate; }
+    float getPredictedRpm() const { return predictedRpm; }
+    float getExpectedRpmRate(int gear) const;
+    bool isShiftLightOn() const { return shiftLight; }
+    bool isOverRev() const { return overRev; }
+private:
+    int fitSlope();
+    static float gearRateScale(int gear);
+    uint64_t times[SHIFT_PREDICTION_WINDOW];
+    float rpms[SHIFT_PREDICTION_WINDOW];
+    int count = 0;
+    int head = 0;
+    int gear = GEAR_NONE;
+    float rpmRate = 0.0f;
+    float fittedRpm = 0.0f;
+    float predictedRpm = 0.0f;
+    float meanIntervalUs = 0.0f;
+    float firstGearRate = 0.0f;
+    uint64_t displayLatencyUs = DISPLAY_LATENCY_US;
+    bool shiftLight = false;
+    bool overRev = false;
+};
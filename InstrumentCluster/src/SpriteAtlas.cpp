@@ -0,0 +1,49 @@
+#include "SpriteAtlas.h"
+#include <SDL2/SDL_image.h>
+#include <iostream>
+
+bool SpriteAtlas::build(TextureManager& textures, const std::vector<std::string>& files) {
+    const int stride = ICON_ATLAS_CELL + 2 * ICON_ATLAS_PADDING;
+    const int rows = ((int)files.size() + ICON_ATLAS_COLUMNS - 1) / ICON_ATLAS_COLUMNS;
+    SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, ICON_ATLAS_COLUMNS * stride, rows * stride, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!atlas) {
+        std::cerr << "Failed to create atlas surface: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_FillRect(atlas, NULL, 0);
+
+    rects.clear();
+    for (size_t i = 0; i < files.size(); ++i) {
+        SDL_Rect cell = {
+            (int)(i % ICON_ATLAS_COLUMNS) * stride + ICON_ATLAS_PADDING,
+            (int)(i / ICON_ATLAS_COLUMNS) * stride + ICON_ATLAS_PADDING,
+            ICON_ATLAS_CELL,
+            ICON_ATLAS_CELL
+        };
+        rects.push_back(cell);
+
+        SDL_Surface* loaded = IMG_Load(files[i].c_str());
+        if (!loaded) {
+            std::cerr << "IMG_Load Error: " << IMG_GetError() << std::endl;
+            continue;
+        }
+        SDL_Surface* image = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(loaded);
+
+        // Halve first so the final linear stretch never skips source pixels
+        while (image && image->w > 2 * ICON_ATLAS_CELL) {
+            SDL_Surface* half = SDL_CreateRGBSurfaceWithFormat(0, image->w / 2, image->h / 2, 32, SDL_PIXELFORMAT_ARGB8888);
+            SDL_SoftStretchLinear(image, NULL, half, NULL);
+            SDL_FreeSurface(image);
+            image = half;
+        }
+        if (image) {
+            SDL_SoftStretchLinear(image, NULL, atlas, &cell);
+            SDL_FreeSurface(image);
+        }
+    }
+
+    texture = textures.acquireStatic(TEXTURE_ATLAS, atlas, false);
+    SDL_FreeSurface(atlas);
+    return texture != nullptr;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include "TextureManager.h"
+
+const int ICON_ATLAS_CELL = 128;
+const int ICON_ATLAS_PADDING = 2;
+const int ICON_ATLAS_COLUMNS = 4;
+
+// Packs square icon images into one texture. Every image is scaled down to
+// ICON_ATLAS_CELL pixels and surrounded by transparent padding, so linear
+// filtering never bleeds between neighbours.
+class SpriteAtlas {
+public:
+    bool build(TextureManager& textures, const std::vector<std::string>& files);
+    SDL_Texture* getTexture() const { return texture; }
+    const SDL_Rect& getRect(int sprite) const { return rects[sprite]; }
+private:
+    SDL_Texture* texture = nullptr;
+    std::vector<SDL_Rect> rects;
+};
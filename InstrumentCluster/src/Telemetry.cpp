@@ -0,0 +1,97 @@
+#include "Telemetry.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+struct Cursor {
+    const char* pos;
+    const char* end;
+};
+
+bool expect(Cursor& cursor, const char* text) {
+    size_t length = strlen(text);
+    if ((size_t)(cursor.end - cursor.pos) < length || memcmp(cursor.pos, text, length) != 0) return false;
+    cursor.pos += length;
+    return true;
+}
+
+bool parseInt(Cursor& cursor, int& value) {
+    bool negative = cursor.pos < cursor.end && *cursor.pos == '-';
+    if (negative) cursor.pos++;
+    const char* start = cursor.pos;
+    long result = 0;
+    while (cursor.pos < cursor.end && *cursor.pos >= '0' && *cursor.pos <= '9' && cursor.pos - start < 9) {
+        result = result * 10 + (*cursor.pos++ - '0');
+    }
+    if (cursor.pos == start) return false;
+    value = (int)(negative ? -result : result);
+    return true;
+}
+
+// Plain decimal notation only, the Arduino prints "nan" and "ovf" for values
+// it can't represent and those lines are rejected.
+bool parseFloat(Cursor& cursor, float& value) {
+    bool negative = cursor.pos < cursor.end && *cursor.pos == '-';
+    if (negative) cursor.pos++;
+    const char* start = cursor.pos;
+    double result = 0.0;
+    while (cursor.pos < cursor.end && *cursor.pos >= '0' && *cursor.pos <= '9') {
+        result = result * 10.0 + (*cursor.pos++ - '0');
+    }
+    bool hasDigits = cursor.pos != start;
+    if (cursor.pos < cursor.end && *cursor.pos == '.') {
+        cursor.pos++;
+        double scale = 0.1;
+        while (cursor.pos < cursor.end && *cursor.pos >= '0' && *cursor.pos <= '9') {
+            result += (*cursor.pos++ - '0') * scale;
+            scale *= 0.1;
+            hasDigits = true;
+        }
+    }
+    if (!hasDigits) return false;
+    value = (float)(negative ? -result : result);
+    return true;
+}
+
+}
+
+bool parseTelemetryLine(const char* line, size_t length, VehicleData& out) {
+    const char* end = line + length;
+    while (end > line && (end[-1] == '\r' || end[-1] == ' ')) end--;
+
+    const char* start = line;
+    while (start + 1 < end && !(start[0] == 'G' && start[1] == ':')) start++;
+    Cursor cursor = {start, end};
+
+    int gear, rpm;
+    float coolant, throttle, load, ambient, voltage;
+    if (!expect(cursor, "G:") || !parseInt(cursor, gear)
+        || !expect(cursor, ",R:") || !parseInt(cursor, rpm)
+        || !expect(cursor, ",T:") || !parseFloat(cursor, coolant)
+        || !expect(cursor, ",Th:") || !parseFloat(cursor, throttle)
+        || !expect(cursor, ",L:") || !parseFloat(cursor, load)
+        || !expect(cursor, ",A:") || !parseFloat(cursor, ambient)
+        || !expect(cursor, ",V:") || !parseFloat(cursor, voltage)
+        || cursor.pos != cursor.end) {
+        return false;
+    }
+
+    out.currentGear = gear;
+    out.engineRpm = rpm;
+    out.coolantTemp = coolant;
+    out.throttle = throttle;
+    out.engineLoad = load;
+    out.ambientTemp = ambient;
+    out.voltage = voltage;
+    return true;
+}
+
+float calculateSpeed(int rpm, int gear) {
+    if (gear <= 0 || gear > (int)GEAR_RATIOS.size() || rpm == 0) {
+        return 0.0f;
+    }
+    float totalRatio = GEAR_RATIOS[gear-1] * FINAL_DRIVE_RATIO;
+    float wheelCircumference = M_PI * WHEEL_DIAMETER_MM;
+    return (rpm * wheelCircumference * 60.0f) / (totalRatio * 1000000.0f);
+}
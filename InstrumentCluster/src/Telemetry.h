@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include "VehicleConstants.h"
+
+// Parses one "G:<gear>,R:<rpm>,T:<coolant>,Th:<throttle>,L:<load>,A:<ambient>,V:<volts>"
+// line as printed by the firmware. Leading noise before "G:" and a trailing
+// '\r' are skipped. Only fills out when the whole line is valid.
+bool parseTelemetryLine(const char* line, size_t length, VehicleData& out);
+
+// Road speed in km/h from engine speed and gear, 0 in neutral
+float calculateSpeed(int rpm, int gear);
@@ -0,0 +1,147 @@
+#include "TelemetryBus.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static void writeSlot(TelemetrySlot& slot, uint64_t index, const VehicleData& data) {
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&slot.data, &data, sizeof(VehicleData));
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+// Returns the finished index stored in the slot, or -1 while it is being written
+static int64_t readSlot(const TelemetrySlot& slot, VehicleData& out) {
+    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before == 0 || before % 2 == 1) return -1;
+    memcpy(&out, &slot.data, sizeof(VehicleData));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+    if (after != before) return -1;
+    return (int64_t)(before / 2 - 1);
+}
+
+TelemetryPublisher::TelemetryPublisher(const std::string& name) : name(name) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "TelemetryBus: shm_open " << name << " failed: " << strerror(errno) << std::endl;
+        return;
+    }
+    if (ftruncate(fd, sizeof(TelemetryBusLayout)) != 0) {
+        std::cerr << "TelemetryBus: ftruncate failed: " << strerror(errno) << std::endl;
+        close(fd);
+        return;
+    }
+    void* memory = mmap(nullptr, sizeof(TelemetryBusLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        std::cerr << "TelemetryBus: mmap failed: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    bus = static_cast<TelemetryBusLayout*>(memory);
+    memset(static_cast<void*>(bus), 0, sizeof(TelemetryBusLayout));
+    bus->version = TELEMETRY_BUS_VERSION;
+    bus->recordSize = sizeof(VehicleData);
+    bus->ringSize = TELEMETRY_RING_SIZE;
+    std::atomic_thread_fence(std::memory_order_release);
+    bus->magic = TELEMETRY_BUS_MAGIC;
+}
+
+TelemetryPublisher::~TelemetryPublisher() {
+    if (bus) {
+        munmap(bus, sizeof(TelemetryBusLayout));
+        shm_unlink(name.c_str());
+    }
+}
+
+void TelemetryPublisher::publish(const VehicleData& data) {
+    if (!bus) return;
+    uint64_t index = bus->writeIndex.load(std::memory_order_relaxed);
+    writeSlot(bus->ring[index % TELEMETRY_RING_SIZE], index, data);
+    writeSlot(bus->latest, index, data);
+    bus->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+TelemetryReader::TelemetryReader(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return;
+    }
+    void* memory = mmap(nullptr, sizeof(TelemetryBusLayout), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return;
+    }
+    bus = static_cast<TelemetryBusLayout*>(memory);
+    if (bus->magic != TELEMETRY_BUS_MAGIC || bus->version != TELEMETRY_BUS_VERSION
+        || bus->recordSize != sizeof(VehicleData) || bus->ringSize != TELEMETRY_RING_SIZE) {
+        std::cerr << "TelemetryBus: incompatible bus " << name << std::endl;
+        munmap(memory, sizeof(TelemetryBusLayout));
+        bus = nullptr;
+        return;
+    }
+    seekToEnd();
+}
+
+TelemetryReader::~TelemetryReader() {
+    if (bus) {
+        munmap(bus, sizeof(TelemetryBusLayout));
+    }
+}
+
+void TelemetryReader::seekToEnd() {
+    if (bus) {
+        cursor = bus->writeIndex.load(std::memory_order_acquire);
+    }
+}
+
+bool TelemetryReader::readLatest(VehicleData& out) const {
+    if (!bus) return false;
+    for (int attempt = 0; attempt < TELEMETRY_READ_RETRIES; ++attempt) {
+        if (readSlot(bus->latest, out) >= 0) return true;
+    }
+    return false;
+}
+
+int TelemetryReader::read(TelemetryRecord* out, int maxRecords) {
+    if (!bus) return 0;
+    uint64_t end = bus->writeIndex.load(std::memory_order_acquire);
+    if (cursor > end) {
+        cursor = end;
+    }
+    // Stay a slot behind the oldest record so the publisher can't catch up mid-copy
+    if (end - cursor >= TELEMETRY_RING_SIZE) {
+        uint64_t oldest = end - TELEMETRY_RING_SIZE + 1;
+        dropped += oldest - cursor;
+        cursor = oldest;
+    }
+
+    int count = 0;
+    while (count < maxRecords && cursor < end) {
+        int64_t index = -1;
+        for (int attempt = 0; attempt < TELEMETRY_READ_RETRIES && index < 0; ++attempt) {
+            index = readSlot(bus->ring[cursor % TELEMETRY_RING_SIZE], out[count].data);
+        }
+        if (index < 0) {
+            // Still mid-write (or the publisher died there), the next poll picks it up
+            break;
+        }
+        if ((uint64_t)index != cursor) {
+            // Overwritten while we were reading, restart from the new oldest record
+            uint64_t oldest = bus->writeIndex.load(std::memory_order_acquire) - TELEMETRY_RING_SIZE + 1;
+            if (oldest > cursor) {
+                dropped += oldest - cursor;
+                cursor = oldest;
+            }
+            break;
+        }
+        out[count].index = cursor;
+        count++;
+        cursor++;
+    }
+    return count;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "VehicleConstants.h"
+
+#define TELEMETRY_BUS_NAME "/dinocar-telemetry"
+
+const uint32_t TELEMETRY_BUS_MAGIC = 0x44435442;
+const uint32_t TELEMETRY_BUS_VERSION = 1;
+const uint64_t TELEMETRY_RING_SIZE = 1024;
+// Reads of a slot caught mid-write before giving up until the next poll
+const int TELEMETRY_READ_RETRIES = 16;
+
+struct TelemetryRecord {
+    uint64_t index;
+    VehicleData data;
+};
+
+// Shared memory layout. Every slot is a seqlock: the writer sets its sequence
+// to 2*index+1 while copying and 2*index+2 when done, so a reader can tell a
+// finished record from one in progress or one already overwritten by a lap.
+struct TelemetrySlot {
+    std::atomic<uint64_t> sequence;
+    VehicleData data;
+};
+
+struct TelemetryBusLayout {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t ringSize;
+    std::atomic<uint64_t> writeIndex;
+    TelemetrySlot latest;
+    TelemetrySlot ring[TELEMETRY_RING_SIZE];
+};
+
+// Single writer, owned by the process reading the serial link.
+class TelemetryPublisher {
+public:
+    explicit TelemetryPublisher(const std::string& name = TELEMETRY_BUS_NAME);
+    ~TelemetryPublisher();
+    bool isOpen() const { return bus != nullptr; }
+    void publish(const VehicleData& data);
+private:
+    std::string name;
+    TelemetryBusLayout* bus = nullptr;
+};
+
+// Any number of readers, each with its own cursor. Readers never block the
+// publisher; a reader that falls more than a ring behind skips ahead and
+// counts the records it lost.
+class TelemetryReader {
+public:
+    explicit TelemetryReader(const std::string& name = TELEMETRY_BUS_NAME);
+    ~TelemetryReader();
+    bool isOpen() const { return bus != nullptr; }
+    bool readLatest(VehicleData& out) const;
+    int read(TelemetryRecord* out, int maxRecords);
+    void seekToEnd();
+    uint64_t getDropped() const { return dropped; }
+private:
+    TelemetryBusLayout* bus = nullptr;
+    uint64_t cursor = 0;
+    uint64_t dropped = 0;
+};
@@ -0,0 +1,409 @@
+#include "TextureManager.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <utility>
+
+static bool isPooled(TexturePurpose purpose) {
+    return purpose == TEXTURE_GLYPH || purpose == TEXTURE_TEXT;
+}
+
+static int roundUp(int value, int granularity) {
+    return (value + granularity - 1) / granularity * granularity;
+}
+
+const char* TextureManager::purposeName(int purpose) {
+    static const char* names[TEXTURE_PURPOSE_COUNT] = {"target", "background", "atlas", "streaming", "glyph", "text"};
+    return purpose >= 0 && purpose < TEXTURE_PURPOSE_COUNT ? names[purpose] : "unknown";
+}
+
+void TextureManager::init(SDL_Renderer* renderer, size_t budgetBytes) {
+    this->renderer = renderer;
+    this->budgetBytes = budgetBytes;
+    live.reserve(TEXTURE_TABLE_CAPACITY);
+    pool.reserve(TEXTURE_TABLE_CAPACITY);
+    if (SDL_GetRendererInfo(renderer, &info) != 0) {
+        std::cerr << "SDL_GetRendererInfo Error: " << SDL_GetError() << std::endl;
+        info.num_texture_formats = 0;
+    }
+    nativeFormat = chooseNativeFormat();
+    SDL_BlendMode premultipliedBlend = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    premultiplied = supportsBlendMode(premultipliedBlend);
+    alphaBlendMode = premultiplied ? premultipliedBlend : SDL_BLENDMODE_BLEND;
+}
+
+// The window's channel order with alpha added, so the final copy to the
+// screen needs no swizzle, else the first 32 bit alpha format of the renderer
+Uint32 TextureManager::chooseNativeFormat() const {
+    static const std::pair<Uint32, Uint32> windowMatches[] = {
+        {SDL_PIXELFORMAT_RGB888, SDL_PIXELFORMAT_ARGB8888},
+        {SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_ARGB8888},
+        {SDL_PIXELFORMAT_BGR888, SDL_PIXELFORMAT_ABGR8888},
+        {SDL_PIXELFORMAT_ABGR8888, SDL_PIXELFORMAT_ABGR8888},
+        {SDL_PIXELFORMAT_RGBX8888, SDL_PIXELFORMAT_RGBA8888},
+        {SDL_PIXELFORMAT_RGBA8888, SDL_PIXELFORMAT_RGBA8888},
+        {SDL_PIXELFORMAT_BGRX8888, SDL_PIXELFORMAT_BGRA8888},
+        {SDL_PIXELFORMAT_BGRA8888, SDL_PIXELFORMAT_BGRA8888}
+    };
+    SDL_Window* window = SDL_RenderGetWindow(renderer);
+    Uint32 windowFormat = window ? SDL_GetWindowPixelFormat(window) : SDL_PIXELFORMAT_UNKNOWN;
+    for (const auto& match : windowMatches) {
+        if (match.first == windowFormat && isNative(match.second)) return match.second;
+    }
+    for (Uint32 i = 0; i < info.num_texture_formats; ++i) {
+        Uint32 format = info.texture_formats[i];
+        if (!SDL_ISPIXELFORMAT_FOURCC(format) && SDL_BITSPERPIXEL(format) == 32 && SDL_ISPIXELFORMAT_ALPHA(format)) {
+            return format;
+        }
+    }
+    return SDL_PIXELFORMAT_ARGB8888;
+}
+
+// The software renderer has no custom blend modes, it keeps straight alpha
+bool TextureManager::supportsBlendMode(SDL_BlendMode mode) {
+    SDL_Texture* probe = SDL_CreateTexture(renderer, nativeFormat, SDL_TEXTUREACCESS_STATIC, 1, 1);
+    if (!probe) return false;
+    bool supported = SDL_SetTextureBlendMode(probe, mode) == 0;
+    SDL_DestroyTexture(probe);
+    return supported;
+}
+
+void TextureManager::premultiply(SDL_Surface* surface) const {
+    if (!premultiplied || surface->format->format != SDL_PIXELFORMAT_ARGB8888) return;
+    if (SDL_MUSTLOCK(surface)) SDL_LockSurface(surface);
+    for (int y = 0; y < surface->h; ++y) {
+        Uint32* row = (Uint32*)((Uint8*)surface->pixels + (size_t)y * surface->pitch);
+        for (int x = 0; x < surface->w; ++x) {
+            Uint32 pixel = row[x];
+            Uint32 alpha = pixel >> 24;
+            if (alpha == 255) continue;
+            Uint32 red = (((pixel >> 16) & 0xFF) * alpha + 127) / 255;
+            Uint32 green = (((pixel >> 8) & 0xFF) * alpha + 127) / 255;
+            Uint32 blue = ((pixel & 0xFF) * alpha + 127) / 255;
+            row[x] = alpha << 24 | red << 16 | green << 8 | blue;
+        }
+    }
+    if (SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
+}
+
+static void unpremultiply(Uint32* pixels, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        Uint32 pixel = pixels[i];
+        Uint32 alpha = pixel >> 24;
+        if (alpha == 255) continue;
+        if (alpha == 0) {
+            pixels[i] = 0;
+            continue;
+        }
+        Uint32 red = std::min(255u, (((pixel >> 16) & 0xFF) * 255 + alpha / 2) / alpha);
+        Uint32 green = std::min(255u, (((pixel >> 8) & 0xFF) * 255 + alpha / 2) / alpha);
+        Uint32 blue = std::min(255u, ((pixel & 0xFF) * 255 + alpha / 2) / alpha);
+        pixels[i] = alpha << 24 | red << 16 | green << 8 | blue;
+    }
+}
+
+bool TextureManager::isNative(Uint32 format) const {
+    for (Uint32 i = 0; i < info.num_texture_formats; ++i) {
+        if (info.texture_formats[i] == format) return true;
+    }
+    return false;
+}
+
+// Only formats the renderer stores as is count, anything else gets converted
+// to a 32 bit texture behind our back and saves nothing. YUV is left out on
+// purpose, chroma subsampling smears the thin gauge edges and text.
+Uint32 TextureManager::compactFormat(bool opaque) const {
+    static const Uint32 opaqueFormats[] = {SDL_PIXELFORMAT_RGB565, SDL_PIXELFORMAT_BGR565};
+    static const Uint32 alphaFormats[] = {SDL_PIXELFORMAT_ARGB4444, SDL_PIXELFORMAT_ABGR4444, SDL_PIXELFORMAT_RGBA4444};
+    if (opaque) {
+        for (Uint32 format : opaqueFormats) {
+            if (isNative(format)) return format;
+        }
+    }
+    for (Uint32 format : alphaFormats) {
+        if (isNative(format)) return format;
+    }
+    return SDL_PIXELFORMAT_UNKNOWN;
+}
+
+// Without a 16 bit format the texture stays 32 bit, logged once so the
+// overrun is not silent
+void TextureManager::keepOverBudget(TexturePurpose purpose, int width, int height) {
+    if (overrunLogged) return;
+    overrunLogged = true;
+    std::cerr << "No native 16 bit texture format, keeping " << purposeName(purpose) << " " << width << "x" << height
+              << " in " << SDL_GetPixelFormatName(nativeFormat) << " over the " << budgetBytes / 1024 << " KiB budget"
+              << std::endl;
+}
+
+size_t TextureManager::textureBytes(Uint32 format, int width, int height) const {
+    if (SDL_ISPIXELFORMAT_FOURCC(format)) {
+        return (size_t)width * height + 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2);
+    }
+    size_t bytesPerPixel = isNative(format) ? SDL_BYTESPERPIXEL(format) : 4;
+    return (size_t)width * height * bytesPerPixel;
+}
+
+SDL_Texture* TextureManager::create(TexturePurpose purpose, Uint32 format, int access, int width, int height) {
+    size_t bytes = textureBytes(format, width, height);
+    if (isOverBudget(bytes)) {
+        trimPool(bytes);
+        if (isOverBudget(bytes)) {
+            overBudget++;
+        }
+    }
+    SDL_Texture* texture = SDL_CreateTexture(renderer, format, access, width, height);
+    if (!texture) {
+        std::cerr << "SDL_CreateTexture Error (" << purposeName(purpose) << " " << width << "x" << height << "): "
+                  << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+    if (!isNative(format)) {
+        nonNative++;
+    }
+    live.push_back({texture, purpose, format, access, width, height, bytes});
+    liveBytes += bytes;
+    peakBytes = std::max(peakBytes, liveBytes);
+    creates++;
+    return texture;
+}
+
+// Index into live, live.size() when the texture is not ours
+size_t TextureManager::find(SDL_Texture* texture) const {
+    size_t i = 0;
+    while (i < live.size() && live[i].texture != texture) {
+        ++i;
+    }
+    return i;
+}
+
+void TextureManager::destroy(SDL_Texture* texture) {
+    size_t i = find(texture);
+    if (i < live.size()) {
+        liveBytes -= live[i].bytes;
+        live[i] = live.back();
+        live.pop_back();
+    }
+    SDL_DestroyTexture(texture);
+    destroys++;
+}
+
+// Recycled textures go first, oldest first
+void TextureManager::trimPool(size_t extraBytes) {
+    while (!pool.empty() && isOverBudget(extraBytes)) {
+        SDL_Texture* texture = pool.front();
+        pool.erase(pool.begin());
+        pooledBytes -= live[find(texture)].bytes;
+        destroy(texture);
+    }
+}
+
+void TextureManager::setBudget(size_t bytes) {
+    budgetBytes = bytes;
+    trimPool(0);
+}
+
+SDL_Texture* TextureManager::acquire(TexturePurpose purpose, Uint32 format, int access, int width, int height) {
+    if (!isPooled(purpose)) {
+        return create(purpose, format, access, width, height);
+    }
+    width = roundUp(width, TEXTURE_POOL_GRANULARITY);
+    height = roundUp(height, TEXTURE_POOL_GRANULARITY);
+    for (size_t i = 0; i < pool.size(); ++i) {
+        Entry& entry = live[find(pool[i])];
+        if (entry.format == format && entry.access == access && entry.width == width && entry.height == height) {
+            SDL_Texture* texture = pool[i];
+            pool.erase(pool.begin() + i);
+            pooledBytes -= entry.bytes;
+            entry.purpose = purpose;
+            SDL_SetTextureColorMod(texture, 255, 255, 255);
+            SDL_SetTextureAlphaMod(texture, 255);
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+            reuses++;
+            return texture;
+        }
+    }
+    return create(purpose, format, access, width, height);
+}
+
+SDL_Texture* TextureManager::acquireFromSurface(TexturePurpose purpose, SDL_Surface* surface) {
+    SDL_Surface* converted = nullptr;
+    if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+        converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (!converted) {
+            std::cerr << "SDL_ConvertSurfaceFormat Error: " << SDL_GetError() << std::endl;
+            return nullptr;
+        }
+        surface = converted;
+    }
+    premultiply(surface);
+    SDL_Texture* texture = acquire(purpose, nativeFormat, SDL_TEXTUREACCESS_STREAMING, surface->w, surface->h);
+    if (texture) {
+        // Converted straight into the texture memory, nothing to allocate
+        SDL_Rect area = {0, 0, surface->w, surface->h};
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(texture, &area, &pixels, &pitch) == 0) {
+            SDL_ConvertPixels(surface->w, surface->h, SDL_PIXELFORMAT_ARGB8888, surface->pixels, surface->pitch,
+                              nativeFormat, pixels, pitch);
+            SDL_UnlockTexture(texture);
+        }
+        SDL_SetTextureBlendMode(texture, alphaBlendMode);
+    }
+    if (converted) {
+        SDL_FreeSurface(converted);
+    }
+    return texture;
+}
+
+SDL_Texture* TextureManager::upload(TexturePurpose purpose, Uint32 format, const void* pixels, Uint32 pixelFormat, int pitch, int width, int height) {
+    SDL_Texture* texture = create(purpose, format, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (!texture) return nullptr;
+    if (format == pixelFormat) {
+        SDL_UpdateTexture(texture, nullptr, pixels, pitch);
+        return texture;
+    }
+    int convertedPitch = SDL_ISPIXELFORMAT_FOURCC(format) ? width : width * SDL_BYTESPERPIXEL(format);
+    std::vector<Uint8> converted(textureBytes(format, width, height));
+    if (SDL_ConvertPixels(width, height, pixelFormat, pixels, pitch, format, converted.data(), convertedPitch) != 0) {
+        std::cerr << "SDL_ConvertPixels Error: " << SDL_GetError() << std::endl;
+        destroy(texture);
+        return nullptr;
+    }
+    SDL_UpdateTexture(texture, nullptr, converted.data(), convertedPitch);
+    return texture;
+}
+
+SDL_Texture* TextureManager::acquireStatic(TexturePurpose purpose, SDL_Surface* surface, bool opaque) {
+    Uint32 format = nativeFormat;
+    if (isOverBudget(textureBytes(format, surface->w, surface->h))) {
+        Uint32 smaller = compactFormat(opaque);
+        if (smaller != SDL_PIXELFORMAT_UNKNOWN) {
+            format = smaller;
+            downgrades++;
+        } else {
+            keepOverBudget(purpose, surface->w, surface->h);
+        }
+    }
+    SDL_Surface* source = surface;
+    if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+        source = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (!source) {
+            std::cerr << "SDL_ConvertSurfaceFormat Error: " << SDL_GetError() << std::endl;
+            return nullptr;
+        }
+    }
+    premultiply(source);
+    SDL_Texture* texture = upload(purpose, format, source->pixels, SDL_PIXELFORMAT_ARGB8888, source->pitch, source->w, source->h);
+    if (source != surface) {
+        SDL_FreeSurface(source);
+    }
+    if (texture) {
+        SDL_SetTextureBlendMode(texture, opaque ? SDL_BLENDMODE_NONE : alphaBlendMode);
+    }
+    return texture;
+}
+
+SDL_Texture* TextureManager::compact(SDL_Texture* target, TexturePurpose purpose) {
+    size_t i = find(target);
+    if (i == live.size() || !isOverBudget()) return target;
+    int width = live[i].width;
+    int height = live[i].height;
+    Uint32 format = compactFormat(true);
+    if (format == SDL_PIXELFORMAT_UNKNOWN) {
+        keepOverBudget(purpose, width, height);
+        return target;
+    }
+
+    std::vector<Uint32> pixels((size_t)width * height);
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, target);
+    int result = SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ARGB8888, pixels.data(), width * 4);
+    SDL_SetRenderTarget(renderer, previousTarget);
+    if (result != 0) {
+        std::cerr << "SDL_RenderReadPixels Error: " << SDL_GetError() << std::endl;
+        return target;
+    }
+
+    SDL_Texture* texture = upload(purpose, format, pixels.data(), SDL_PIXELFORMAT_ARGB8888, width * 4, width, height);
+    if (!texture) return target;
+    destroy(target);
+    downgrades++;
+    return texture;
+}
+
+// Blending into a cleared target leaves premultiplied color behind with
+// either blend mode. Without the premultiplied mode it is read back and
+// divided by alpha, the buffer stays for the next composition.
+void TextureManager::finishComposed(SDL_Texture* target) {
+    if (premultiplied) {
+        SDL_SetTextureBlendMode(target, alphaBlendMode);
+        return;
+    }
+    size_t i = find(target);
+    if (i == live.size()) return;
+    int width = live[i].width;
+    int height = live[i].height;
+    size_t pixelCount = (size_t)width * height;
+    if (composeBuffer.size() < 2 * pixelCount) {
+        composeBuffer.resize(2 * pixelCount);
+    }
+    Uint32* straight = composeBuffer.data();
+    Uint32* converted = straight + pixelCount;
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, target);
+    int result = SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ARGB8888, straight, width * 4);
+    SDL_SetRenderTarget(renderer, previousTarget);
+    if (result != 0) {
+        std::cerr << "SDL_RenderReadPixels Error: " << SDL_GetError() << std::endl;
+    } else {
+        unpremultiply(straight, pixelCount);
+        SDL_ConvertPixels(width, height, SDL_PIXELFORMAT_ARGB8888, straight, width * 4,
+                          live[i].format, converted, width * 4);
+        SDL_UpdateTexture(target, nullptr, converted, width * 4);
+    }
+    SDL_SetTextureBlendMode(target, SDL_BLENDMODE_BLEND);
+}
+
+void TextureManager::release(SDL_Texture* texture) {
+    if (!texture) return;
+    size_t i = find(texture);
+    if (i == live.size()) {
+        SDL_DestroyTexture(texture);
+        return;
+    }
+    if (isPooled(live[i].purpose) && pooledBytes + live[i].bytes <= TEXTURE_POOL_MAX_BYTES) {
+        pool.push_back(texture);
+        pooledBytes += live[i].bytes;
+        return;
+    }
+    destroy(texture);
+}
+
+void TextureManager::clear() {
+    for (const Entry& entry : live) {
+        SDL_DestroyTexture(entry.texture);
+    }
+    destroys += live.size();
+    live.clear();
+    pool.clear();
+    liveBytes = 0;
+    pooledBytes = 0;
+}
+
+TextureStats TextureManager::getStats() const {
+    TextureStats stats = {liveBytes, peakBytes, pooledBytes, budgetBytes, creates, reuses, destroys, downgrades, nonNative, overBudget, {}, {}};
+    std::map<Uint32, size_t> formats;
+    for (const Entry& entry : live) {
+        formats[entry.format] += entry.bytes;
+        stats.purposeBytes[entry.purpose] += entry.bytes;
+    }
+    for (SDL_Texture* texture : pool) {
+        const Entry& entry = live[find(texture)];
+        stats.purposeBytes[entry.purpose] -= entry.bytes;
+    }
+    stats.formatBytes.assign(formats.begin(), formats.end());
+    return stats;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Keeps the static layers, render targets and text of the cluster well inside
+// the gpu_mem=64 split, which also has to hold the scanout buffers.
+const size_t TEXTURE_BUDGET_BYTES = 4 * 1024 * 1024;
+const size_t TEXTURE_POOL_MAX_BYTES = 512 * 1024;
+const int TEXTURE_POOL_GRANULARITY = 32;
+// Live textures the table holds without growing, well above the cluster's
+// layers plus a full pool of the smallest text textures
+const size_t TEXTURE_TABLE_CAPACITY = 256;
+
+enum TexturePurpose {
+    TEXTURE_TARGET,
+    TEXTURE_BACKGROUND,
+    TEXTURE_ATLAS,
+    TEXTURE_STREAMING,
+    TEXTURE_GLYPH,
+    TEXTURE_TEXT,
+    TEXTURE_PURPOSE_COUNT
+};
+
+struct TextureStats {
+    size_t liveBytes;
+    size_t peakBytes;
+    size_t pooledBytes;
+    size_t budgetBytes;
+    unsigned long creates;
+    unsigned long reuses;
+    unsigned long destroys;
+    unsigned long downgrades;
+    unsigned long nonNative;
+    unsigned long overBudget;
+    size_t purposeBytes[TEXTURE_PURPOSE_COUNT];
+    std::vector<std::pair<Uint32, size_t>> formatBytes;
+};
+
+// Owner of every SDL_Texture of the renderer. Glyph and text textures are
+// rounded up to TEXTURE_POOL_GRANULARITY and recycled through a pool, so
+// callers draw them with a source rect of the size they asked for. Static
+// layers are stored in a smaller native format while over budget. Later
+// creations give up pooled textures to stay inside it, whatever still doesn't
+// fit is created anyway and counted in overBudget.
+// Everything else uses getNativeFormat(), the renderer's own 32 bit layout
+// closest to the window, and surfaces are uploaded with premultiplied alpha
+// when the renderer can blend that (isPremultiplied()).
+class TextureManager {
+public:
+    void init(SDL_Renderer* renderer, size_t budgetBytes = TEXTURE_BUDGET_BYTES);
+    SDL_Texture* acquire(TexturePurpose purpose, Uint32 format, int access, int width, int height);
+    // Both premultiply the surface in place
+    SDL_Texture* acquireFromSurface(TexturePurpose purpose, SDL_Surface* surface);
+    SDL_Texture* acquireStatic(TexturePurpose purpose, SDL_Surface* surface, bool opaque);
+    SDL_Texture* compact(SDL_Texture* target, TexturePurpose purpose);
+    // Blend mode for a target composed by blending into a cleared texture
+    void finishComposed(SDL_Texture* target);
+    void release(SDL_Texture* texture);
+    void clear();
+    void setBudget(size_t bytes);
+    bool isOverBudget(size_t extraBytes = 0) const { return liveBytes + extraBytes > budgetBytes; }
+    Uint32 getNativeFormat() const { return nativeFormat; }
+    bool isPremultiplied() const { return premultiplied; }
+    SDL_BlendMode getAlphaBlendMode() const { return alphaBlendMode; }
+    TextureStats getStats() const;
+    static const char* purposeName(int purpose);
+private:
+    struct Entry {
+        SDL_Texture* texture;
+        TexturePurpose purpose;
+        Uint32 format;
+        int access;
+        int width, height;
+        size_t bytes;
+    };
+    SDL_Texture* create(TexturePurpose purpose, Uint32 format, int access, int width, int height);
+    size_t find(SDL_Texture* texture) const;
+    void destroy(SDL_Texture* texture);
+    void trimPool(size_t extraBytes);
+    bool isNative(Uint32 format) const;
+    Uint32 chooseNativeFormat() const;
+    bool supportsBlendMode(SDL_BlendMode mode);
+    void premultiply(SDL_Surface* surface) const;
+    Uint32 compactFormat(bool opaque) const;
+    void keepOverBudget(TexturePurpose purpose, int width, int height);
+    size_t textureBytes(Uint32 format, int width, int height) const;
+    SDL_Texture* upload(TexturePurpose purpose, Uint32 format, const void* pixels, Uint32 pixelFormat, int pitch, int width, int height);
+    SDL_Renderer* renderer = nullptr;
+    SDL_RendererInfo info = {};
+    Uint32 nativeFormat = SDL_PIXELFORMAT_ARGB8888;
+    bool premultiplied = false;
+    bool overrunLogged = false;
+    SDL_BlendMode alphaBlendMode = SDL_BLENDMODE_BLEND;
+    // Reserved in init() and searched linearly, so creating a texture in the
+    // frame loop never allocates here
+    std::vector<Entry> live;
+    std::vector<SDL_Texture*> pool;
+    std::vector<Uint32> composeBuffer;
+    size_t budgetBytes = TEXTURE_BUDGET_BYTES;
+    size_t liveBytes = 0;
+    size_t peakBytes = 0;
+    size_t pooledBytes = 0;
+    unsigned long creates = 0;
+    unsigned long reuses = 0;
+    unsigned long destroys = 0;
+    unsigned long downgrades = 0;
+    unsigned long nonNative = 0;
+    unsigned long overBudget = 0;
+};
@@ -0,0 +1,145 @@
+#include "Trace.h"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace {
+
+struct TraceBuffer {
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+    std::atomic<uint64_t> count{0};
+    long threadId = 0;
+    const char* threadName = nullptr;
+};
+
+std::mutex registryMutex;
+std::vector<TraceBuffer*> registry;
+std::atomic<bool> dumpRequested{false};
+thread_local TraceBuffer* localBuffer = nullptr;
+
+// Buffers are never freed, an export may still walk them after their thread exited
+TraceBuffer* threadBuffer() {
+    if (!localBuffer) {
+        localBuffer = new TraceBuffer();
+        localBuffer->threadId = syscall(SYS_gettid);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(localBuffer);
+    }
+    return localBuffer;
+}
+
+void record(const TraceEvent& event) {
+    TraceBuffer* buffer = threadBuffer();
+    uint64_t index = buffer->count.load(std::memory_order_relaxed);
+    buffer->events[index % TRACE_BUFFER_EVENTS] = event;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void onDumpSignal(int) {
+    dumpRequested = true;
+}
+
+}
+
+uint64_t Trace::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::zone(const char* name, uint64_t startNs, uint64_t endNs) {
+    record({name, startNs, endNs - startNs, 0.0, TRACE_EVENT_ZONE});
+}
+
+void Trace::counter(const char* name, double value) {
+    record({name, nowNs(), 0, value, TRACE_EVENT_COUNTER});
+}
+
+void Trace::setThreadName(const char* name) {
+    threadBuffer()->threadName = name;
+}
+
+// Other threads keep recording during the export. Skipping the oldest part
+// of a full ring keeps us clear of the slots they are about to overwrite.
+bool Trace::writeChromeJson(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        std::cerr << "Trace: cannot write " << path << std::endl;
+        return false;
+    }
+    const uint64_t safetyMargin = TRACE_BUFFER_EVENTS / 16;
+    std::vector<TraceBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers = registry;
+    }
+
+    long pid = getpid();
+    bool first = true;
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (TraceBuffer* buffer : buffers) {
+        uint64_t end = buffer->count.load(std::memory_order_acquire);
+        uint64_t begin = end > TRACE_BUFFER_EVENTS - safetyMargin ? end - (TRACE_BUFFER_EVENTS - safetyMargin) : 0;
+        if (buffer->threadName) {
+            fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", pid, buffer->threadId, buffer->threadName);
+            first = false;
+        }
+        for (uint64_t i = begin; i < end; ++i) {
+            const TraceEvent& event = buffer->events[i % TRACE_BUFFER_EVENTS];
+            if (event.type == TRACE_EVENT_ZONE) {
+                fprintf(file, "%s{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%ld,\"tid\":%ld,\"ts\":%.3f,\"dur\":%.3f}",
+                        first ? "" : ",\n", event.name, pid, buffer->threadId, event.timeNs / 1e3, event.durationNs / 1e3);
+            } else {
+                fprintf(file, "%s{\"ph\":\"C\",\"name\":\"%s\",\"pid\":%ld,\"tid\":%ld,\"ts\":%.3f,\"args\":{\"value\":%g}}",
+                        first ? "" : ",\n", event.name, pid, buffer->threadId, event.timeNs / 1e3, event.value);
+            }
+            first = false;
+        }
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(file);
+    return true;
+}
+
+// The handler only raises a flag, the main loop does the actual export
+void Trace::installSignalHandler() {
+    struct sigaction action = {};
+    action.sa_handler = onDumpSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+}
+
+bool Trace::takeDumpRequest() {
+    return dumpRequested.exchange(false);
+}
+
+TraceBenchmark Trace::benchmark(int iterations) {
+    auto elapsedNs = [](uint64_t start) { return (double)(nowNs() - start); };
+    TraceBenchmark result = {0.0, 0.0, 0.0};
+
+    uint64_t start = nowNs();
+    volatile uint64_t sink = 0;
+    for (int i = 0; i < iterations; ++i) {
+        sink = sink + nowNs();
+    }
+    result.clockNs = elapsedNs(start) / iterations;
+
+    start = nowNs();
+    for (int i = 0; i < iterations; ++i) {
+        TraceZone zone("bench.zone");
+    }
+    result.zoneNs = elapsedNs(start) / iterations;
+
+    start = nowNs();
+    for (int i = 0; i < iterations; ++i) {
+        counter("bench.counter", i);
+    }
+    result.counterNs = elapsedNs(start) / iterations;
+    return result;
+}
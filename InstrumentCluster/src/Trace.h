@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#ifndef CLUSTER_TRACING
+#define CLUSTER_TRACING 1
+#endif
+
+const uint32_t TRACE_BUFFER_EVENTS = 1 << 15;
+
+enum TraceEventType : uint32_t {
+    TRACE_EVENT_ZONE,
+    TRACE_EVENT_COUNTER
+};
+
+struct TraceEvent {
+    const char* name;
+    uint64_t timeNs;
+    uint64_t durationNs;
+    double value;
+    TraceEventType type;
+};
+
+struct TraceBenchmark {
+    double zoneNs;
+    double counterNs;
+    double clockNs;
+};
+
+// Events go into a ring owned by the recording thread, so recording never
+// takes a lock. Names must be string literals, only the pointer is stored.
+// The newest TRACE_BUFFER_EVENTS events per thread survive until an export.
+namespace Trace {
+    uint64_t nowNs();
+    void zone(const char* name, uint64_t startNs, uint64_t endNs);
+    void counter(const char* name, double value);
+    void setThreadName(const char* name);
+    bool writeChromeJson(const std::string& path);
+    void installSignalHandler();
+    bool takeDumpRequest();
+    TraceBenchmark benchmark(int iterations);
+}
+
+class TraceZone {
+public:
+    explicit TraceZone(const char* name) : name(name), startNs(Trace::nowNs()) {}
+    ~TraceZone() { Trace::zone(name, startNs, Trace::nowNs()); }
+private:
+    const char* name;
+    uint64_t startNs;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#if CLUSTER_TRACING
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_COUNTER(name, value) Trace::counter(name, (double)(value))
+#define TRACE_THREAD_NAME(name) Trace::setThreadName(name)
+#else
+#define TRACE_ZONE(name) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+#define TRACE_THREAD_NAME(name) do {} while (0)
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 
 const int RPM_MAX = 12000;
 const float THROTTLE_MAX = 80.0f;
@@ -13,10 +14,6 @@ const float SECONDARY_REDUCTION = 37.0f / 15.0f; // ~2.47
 const float INVERT_GEARBOX_REDUCTION = 5.0f / 4.0f; // 1.25
 const float FINAL_DRIVE_RATIO = PRIMARY_REDUCTION * SECONDARY_REDUCTION * INVERT_GEARBOX_REDUCTION;
 
-const int NEUTRAL_ANGLE = 86;
-const int SHIFT_UP_ANGLE = NEUTRAL_ANGLE - 32;
-const int SHIFT_DOWN_ANGLE = NEUTRAL_ANGLE + 25;
-
 #define IS_RASPI (__arm__ || __aarch64__)
 
 enum Gear {
@@ -49,4 +46,8 @@ struct VehicleData {
     float ambientTemp = 0.0f;
     float voltage = 0.0f;
     bool clutchPressed = false;
+    uint64_t sampleTimeUs = 0;
+    bool shiftLight = false;
+    bool overRev = false;
+    bool stale = false;
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "TextureManager.h"
+
+struct WidgetStats {
+    const char* name;
+    unsigned long hits;
+    unsigned long misses;
+};
+
+// Holds the prepared texture of a gauge together with the quantized input it
+// was built from. The owner only re-renders when needsUpdate() reports a new key.
+// Textures come from the TextureManager pool and may be larger than the
+// output rect, only the top left rect sized area is drawn.
+template <typename Key>
+class CachedWidget {
+public:
+    CachedWidget(const char* name, TextureManager& textures) : name(name), textures(textures) {}
+
+    bool needsUpdate(const Key& key) {
+        if (valid && key == lastKey) {
+            hits++;
+            return false;
+        }
+        misses++;
+        lastKey = key;
+        valid = true;
+        return true;
+    }
+
+    void setOutput(SDL_Texture* newTexture, const SDL_Rect& newRect) {
+        textures.release(texture);
+        texture = newTexture;
+        rect = newRect;
+    }
+
+    void release() {
+        textures.release(texture);
+        texture = nullptr;
+        valid = false;
+    }
+
+    void draw(SDL_Renderer* renderer) const {
+        if (texture) {
+            SDL_Rect src = {0, 0, rect.w, rect.h};
+            SDL_RenderCopy(renderer, texture, &src, &rect);
+        }
+    }
+
+    WidgetStats stats() const { return {name, hits, misses}; }
+private:
+    const char* name;
+    TextureManager& textures;
+    Key lastKey{};
+    bool valid = false;
+    SDL_Texture* texture = nullptr;
+    SDL_Rect rect = {0, 0, 0, 0};
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+};
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Animation.h"
+
+// Replays one recorded-style telemetry series through the same SampleTrack and
+// DampedValue steps as Renderer::update() at several frame rates and compares
+// the trajectories at the frames all rates share.
+const uint64_t TELEMETRY_PERIOD_US = 20000;
+const uint64_t TELEMETRY_JITTER_US = 4000;
+const uint64_t REPLAY_US = 8000000;
+// Renderer::update() takes a zero timestamp as "no previous frame"
+const uint64_t CLOCK_BASE_US = 1000000;
+const int COMPARE_RATE_HZ = 30;
+const int FRAME_RATES_HZ[] = {30, 60, 120};
+// A frame can only show the newest sample it sees, so around the corner of a
+// shift a slower display is up to one frame behind. Fed the target as a
+// function of time, the filter alone has to match almost exactly.
+const float RPM_TOLERANCE = 60.0f;
+const float THROTTLE_TOLERANCE = 3.5f;
+const float FILTER_RPM_TOLERANCE = 2.0f;
+const float FILTER_THROTTLE_TOLERANCE = 0.05f;
+// The per-frame smoothing this replaced, for comparison only
+const float LEGACY_SMOOTHING_FACTOR = 0.7f;
+
+enum ReplayMode { REPLAY_PIPELINE, REPLAY_FILTER, REPLAY_LEGACY };
+
+struct Sample {
+    uint64_t timeUs;
+    float rpm;
+    float throttle;
+};
+
+static float interpolate(const double (*points)[2], int count, double t) {
+    if (t <= points[0][0]) return points[0][1];
+    for (int i = 1; i < count; ++i) {
+        if (t <= points[i][0]) {
+            double ratio = (t - points[i - 1][0]) / (points[i][0] - points[i - 1][0]);
+            return points[i - 1][1] + ratio * (points[i][1] - points[i - 1][1]);
+        }
+    }
+    return points[count - 1][1];
+}
+
+// Idle, a full throttle pull, a 130 ms shift, a second pull, a hold at the
+// limiter and a lift off. Breakpoints are in 30 Hz frames, so a target read
+// straight from these is linear between the frames of every rate.
+static const double RPM_POINTS[][2] = {
+    {0, 1000}, {15, 1000}, {75, 9000}, {79, 6200}, {135, 9050}, {180, 9050}, {220, 1000}
+};
+static const double THROTTLE_POINTS[][2] = {
+    {0, 0}, {12, 0}, {14, 72}, {73, 72}, {76, 0}, {79, 0}, {81, 72}, {180, 72}, {182, 0}
+};
+
+static float rpmAt(uint64_t timeUs) {
+    return interpolate(RPM_POINTS, sizeof(RPM_POINTS) / sizeof(RPM_POINTS[0]), timeUs * COMPARE_RATE_HZ / 1e6);
+}
+
+static float throttleAt(uint64_t timeUs) {
+    return interpolate(THROTTLE_POINTS, sizeof(THROTTLE_POINTS) / sizeof(THROTTLE_POINTS[0]), timeUs * COMPARE_RATE_HZ / 1e6);
+}
+
+// Serial lines arrive around the nominal period, a fixed LCG keeps every
+// run identical. The first one is there at frame 0 for every rate.
+static std::vector<Sample> makeSeries() {
+    std::vector<Sample> series;
+    uint32_t state = 12345;
+    for (uint64_t nominal = 0; nominal < REPLAY_US; nominal += TELEMETRY_PERIOD_US) {
+        state = state * 1664525u + 1013904223u;
+        uint64_t timeUs = nominal ? nominal + (state >> 8) % TELEMETRY_JITTER_US : 0;
+        series.push_back({timeUs, rpmAt(timeUs), throttleAt(timeUs)});
+    }
+    return series;
+}
+
+struct Channel {
+    SampleTrack track{MAX_SAMPLE_EXTRAPOLATION_US};
+    DampedValue filter;
+
+    explicit Channel(float omega) : filter(omega) {}
+};
+
+struct Trajectory {
+    std::vector<float> rpm;
+    std::vector<float> throttle;
+};
+
+// Same order as Renderer::update(): push the newest sample the frame can
+// see, sample the track at the frame time, step the filter by the elapsed time
+static Trajectory replay(const std::vector<Sample>& series, int rateHz, ReplayMode mode) {
+    Channel rpm(NEEDLE_OMEGA), throttle(BAR_OMEGA);
+    Trajectory trajectory;
+    size_t next = 0, pushed = 0;
+    uint64_t lastUpdateUs = 0;
+    int stride = rateHz / COMPARE_RATE_HZ;
+    for (uint64_t frame = 0;; ++frame) {
+        uint64_t nowUs = frame * 1000000 / rateHz;
+        if (nowUs >= REPLAY_US) break;
+        while (next < series.size() && series[next].timeUs <= nowUs) ++next;
+        if (next > pushed) {
+            const Sample& sample = series[next - 1];
+            rpm.track.push(CLOCK_BASE_US + sample.timeUs, sample.rpm);
+            throttle.track.push(CLOCK_BASE_US + sample.timeUs, sample.throttle);
+            pushed = next;
+        }
+        uint64_t clockUs = CLOCK_BASE_US + nowUs;
+        float dt = lastUpdateUs ? std::min((float)(clockUs - lastUpdateUs) / 1e6f, MAX_ANIMATION_STEP) : 0.0f;
+        lastUpdateUs = clockUs;
+        float rpmTarget = mode == REPLAY_FILTER ? rpmAt(nowUs) : rpm.track.sample(clockUs);
+        float throttleTarget = mode == REPLAY_FILTER ? throttleAt(nowUs) : throttle.track.sample(clockUs);
+        if (mode == REPLAY_LEGACY) {
+            const float k = LEGACY_SMOOTHING_FACTOR;
+            rpm.filter.reset(k * series[next - 1].rpm + (1 - k) * rpm.filter.value());
+            throttle.filter.reset(k * series[next - 1].throttle + (1 - k) * throttle.filter.value());
+        } else {
+            rpm.filter.update(rpmTarget, dt);
+            throttle.filter.update(throttleTarget, dt);
+        }
+        if (frame % stride == 0) {
+            trajectory.rpm.push_back(rpm.filter.value());
+            trajectory.throttle.push_back(throttle.filter.value());
+        }
+    }
+    return trajectory;
+}
+
+static float maxDifference(const std::vector<float>& a, const std::vector<float>& b) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+        worst = std::max(worst, fabsf(a[i] - b[i]));
+    }
+    return a.size() == b.size() ? worst : INFINITY;
+}
+
+// Negative tolerances only report
+static bool compare(const char* name, const std::vector<Sample>& series, ReplayMode mode, float rpmTolerance,
+                    float throttleTolerance, bool verbose) {
+    std::vector<Trajectory> trajectories;
+    for (int rateHz : FRAME_RATES_HZ) {
+        trajectories.push_back(replay(series, rateHz, mode));
+    }
+    const Trajectory& reference = trajectories.back();
+    bool ok = true;
+    for (int i = 0; i < 2; ++i) {
+        float rpm = maxDifference(trajectories[i].rpm, reference.rpm);
+        float throttle = maxDifference(trajectories[i].throttle, reference.throttle);
+        bool pass = rpm <= rpmTolerance && throttle <= throttleTolerance;
+        printf("  %-14s %3d Hz  needle max %7.2f rpm  throttle max %6.3f %%", name, FRAME_RATES_HZ[i], rpm, throttle);
+        if (rpmTolerance >= 0.0f) {
+            printf("  (limit %.0f rpm, %.2f %%)  %s", rpmTolerance, throttleTolerance, pass ? "ok" : "FAILED");
+            ok &= pass;
+        }
+        printf("\n");
+    }
+    if (verbose) {
+        for (size_t i = 0; i < reference.rpm.size(); ++i) {
+            printf("    %-10s %.4f %.1f %.1f %.1f\n", name, (double)i / COMPARE_RATE_HZ, trajectories[0].rpm[i],
+                   trajectories[1].rpm[i], reference.rpm[i]);
+        }
+    }
+    return ok;
+}
+
+static void printUsage() {
+    std::cerr << "Usage: AnimationReplay [--verbose]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    bool verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<Sample> series = makeSeries();
+    printf("%zu telemetry samples over %.1f s, compared at %d Hz against %d Hz:\n", series.size(), REPLAY_US / 1e6,
+           COMPARE_RATE_HZ, FRAME_RATES_HZ[2]);
+    bool ok = compare("filter", series, REPLAY_FILTER, FILTER_RPM_TOLERANCE, FILTER_THROTTLE_TOLERANCE, verbose);
+    ok &= compare("renderer", series, REPLAY_PIPELINE, RPM_TOLERANCE, THROTTLE_TOLERANCE, verbose);
+    compare("per-frame 0.7", series, REPLAY_LEGACY, -1.0f, -1.0f, false);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CanFrameRing.h"
+#include "CanDecoder.h"
+
+// Replays the bus traffic of can_publish.py plus the OBD answers of the car
+// through the firmware's receive path: the MCP2515 mask, the interrupt side
+// of CanFrameRing and the drain in loop() through decodeCanFrame().
+const int CYCLE_PERIOD_MS = 50;
+const int RING_SIZE = 32;
+const float AMBIENT_TEMP = 22.5f;
+const float COOLANT_TEMP = 85.0f;
+
+struct Recording {
+    std::vector<CanFrame> frames;
+    int engineFrames = 0;
+    uint16_t lastRpm = 0;
+    uint8_t lastGear = 0;
+};
+
+static CanFrame makeFrame(uint16_t id, std::initializer_list<uint8_t> data) {
+    CanFrame frame;
+    frame.id = id;
+    frame.length = 0;
+    memset(frame.data, 0, sizeof(frame.data));
+    for (uint8_t byte : data) frame.data[frame.length++] = byte;
+    return frame;
+}
+
+static CanFrame engineFrame(uint16_t rpm, uint8_t gear, float coolant) {
+    int temp = (int)(coolant * 10);
+    return makeFrame(CAN_ID_ENGINE, {0x02, (uint8_t)(rpm >> 8), (uint8_t)rpm, (uint8_t)(gear & 0x0F), 0, 0,
+                                     (uint8_t)(temp >> 8), (uint8_t)temp});
+}
+
+// One can_publish.py demo cycle per CYCLE_PERIOD_MS, the car answers the
+// sketch's OBD requests every fourth cycle
+static Recording record(int cycles) {
+    Recording recording;
+    uint16_t rpm = 0;
+    uint8_t gear = 1;
+    int ambient = (int)(AMBIENT_TEMP * 10);
+    for (int cycle = 0; cycle < cycles; ++cycle) {
+        recording.frames.push_back(engineFrame(rpm, gear, COOLANT_TEMP));
+        recording.engineFrames++;
+        recording.lastRpm = rpm;
+        recording.lastGear = gear;
+        recording.frames.push_back(makeFrame(0x541, {0x06, 0, 0, 0, 0, 0, 0, 0}));
+        recording.frames.push_back(makeFrame(0x541, {0x02, 0, 0, 0, 0, 0, (uint8_t)(ambient >> 8), (uint8_t)ambient}));
+        recording.frames.push_back(makeFrame(0x541, {0x06, 0, 0, 0, 0, 0, 0, 0}));
+        uint16_t speed = rpm / 100 * 16;
+        for (uint16_t id = 0x12A; id <= 0x12D; ++id) {
+            recording.frames.push_back(makeFrame(id, {(uint8_t)(speed >> 8), (uint8_t)speed, 0, 0, 0, 0, 0, 0}));
+        }
+        if (cycle % 4 == 0) {
+            recording.frames.push_back(makeFrame(CAN_ID_OBD_RESPONSE, {0x03, 0x41, 0x11, 0x80, 0x55, 0x55, 0x55, 0x55}));
+            recording.frames.push_back(makeFrame(CAN_ID_OBD_RESPONSE, {0x03, 0x41, 0x0F, 0x3E, 0x55, 0x55, 0x55, 0x55}));
+            recording.frames.push_back(makeFrame(CAN_ID_OBD_RESPONSE, {0x03, 0x41, 0x04, 0x40, 0x55, 0x55, 0x55, 0x55}));
+        }
+        rpm += 50;
+        if (rpm > 12000) {
+            rpm = 0;
+            gear = gear % 6 + 1;
+        }
+    }
+    return recording;
+}
+
+// What the MCP2515 lets through with the filter the sketch programs
+static bool passesFilter(uint16_t id) {
+    return (id & CAN_FILTER_MASK) == (CAN_FILTER_ID & CAN_FILTER_MASK);
+}
+
+static bool expect(bool condition, const char* what) {
+    printf("  %-52s %s\n", what, condition ? "ok" : "FAILED");
+    return condition;
+}
+
+static bool checkFilter() {
+    printf("filter 0x%03X mask 0x%03X:\n", CAN_FILTER_ID, CAN_FILTER_MASK);
+    bool ok = expect(passesFilter(CAN_ID_ENGINE), "passes 0x540");
+    ok &= expect(passesFilter(CAN_ID_OBD_RESPONSE), "passes 0x7E8");
+    ok &= expect(!passesFilter(0x541), "rejects 0x541");
+    bool abs = false;
+    for (uint16_t id = 0x12A; id <= 0x12D; ++id) abs |= passesFilter(id);
+    ok &= expect(!abs, "rejects 0x12A-0x12D");
+    int passing = 0;
+    for (uint16_t id = 0; id <= 0x7FF; ++id) passing += passesFilter(id);
+    ok &= expect(passing == 16, "lets 16 of 2048 IDs through");
+    return ok;
+}
+
+// Drained every 8 frames, like a loop() that is busy in between
+static bool checkReplay(int cycles) {
+    Recording recording = record(cycles);
+    CanFrameRing<RING_SIZE> ring;
+    CanState state;
+    int samples = 0, delivered = 0;
+    uint16_t lastRpm = 0;
+    bool ordered = true;
+    auto drain = [&] {
+        CanFrame frame;
+        while (ring.pop(frame)) {
+            delivered++;
+            if (!decodeCanFrame(frame, state)) continue;
+            ordered &= samples == 0 || state.rpm == lastRpm + 50 || state.rpm == 0;
+            lastRpm = state.rpm;
+            samples++;
+        }
+    };
+    int filtered = 0;
+    for (size_t i = 0; i < recording.frames.size(); ++i) {
+        if (!passesFilter(recording.frames[i].id)) continue;
+        filtered++;
+        ring.push(recording.frames[i]);
+        if (filtered % 8 == 0) drain();
+    }
+    drain();
+
+    printf("%zu recorded frames over %.1f s, %d through the filter:\n", recording.frames.size(),
+           cycles * CYCLE_PERIOD_MS / 1000.0, filtered);
+    bool ok = expect(ring.received == (uint32_t)filtered && ring.dropped == 0 && delivered == filtered,
+                     "every filtered frame reaches loop()");
+    ok &= expect(samples == recording.engineFrames && ordered, "one engine sample per 0x540, in order");
+    ok &= expect(state.rpm == recording.lastRpm && state.gear == recording.lastGear, "last rpm and gear decoded");
+    ok &= expect(state.coolantTemp == COOLANT_TEMP, "coolant decoded");
+    ok &= expect(state.ambiTemp == 0x3E - 40 && state.throttle > 50.0f && state.throttle < 50.3f
+                 && state.engineLoad > 25.0f && state.engineLoad < 25.2f, "OBD throttle, ambient and load decoded");
+    ok &= expect(state.ignored == 0, "nothing ignored behind the filter");
+    return ok;
+}
+
+static bool checkLengths() {
+    printf("frame lengths:\n");
+    CanState state;
+    CanFrame frame = engineFrame(4000, 3, COOLANT_TEMP);
+    frame.length = 7;
+    bool ok = expect(!decodeCanFrame(frame, state) && state.rpm == 0 && state.ignored == 1,
+                     "0x540 shorter than 8 bytes is ignored");
+    frame.length = 8;
+    ok &= expect(decodeCanFrame(frame, state) && state.rpm == 4000 && state.gear == 3, "0x540 with 8 bytes is decoded");
+    frame.data[0] = 0x06;
+    ok &= expect(!decodeCanFrame(frame, state) && state.rpm == 4000, "0x540 without the 0x02 marker is skipped");
+    CanFrame obd = makeFrame(CAN_ID_OBD_RESPONSE, {0x02, 0x41, 0x11});
+    ok &= expect(!decodeCanFrame(obd, state) && state.throttle < 0.0f && state.ignored == 2,
+                 "0x7E8 shorter than 4 bytes is ignored");
+    CanFrame other = makeFrame(0x548, {0x02, 0, 0, 0, 0, 0, 0, 0});
+    ok &= expect(!decodeCanFrame(other, state) && state.ignored == 3, "an ID the mask lets through is counted");
+    return ok;
+}
+
+static bool checkOverflow() {
+    printf("ring of %d while loop() is stuck:\n", RING_SIZE);
+    CanFrameRing<RING_SIZE> ring;
+    int accepted = 0;
+    for (int i = 0; i < RING_SIZE + 8; ++i) {
+        accepted += ring.push(engineFrame(i, 1, COOLANT_TEMP));
+    }
+    bool ok = expect(accepted == RING_SIZE - 1 && ring.dropped == 9 && ring.received == RING_SIZE - 1,
+                     "holds N - 1 frames and counts the rest as dropped");
+    CanFrame frame;
+    bool oldestFirst = true;
+    for (int i = 0; ring.pop(frame); ++i) {
+        oldestFirst &= frame.data[2] == i;
+    }
+    ok &= expect(oldestFirst, "keeps the oldest frames in order");
+    ok &= expect(ring.push(engineFrame(1, 1, COOLANT_TEMP)), "accepts frames again once drained");
+    return ok;
+}
+
+// CAN_RING_BARRIER only stops the compiler, which is all AVR and the strongly
+// ordered x86 need. Elsewhere the two threads would also need fences.
+static bool checkThreads(int frames) {
+#if defined(__x86_64__) || defined(__i386__)
+    printf("%d frames from a second thread:\n", frames);
+    CanFrameRing<RING_SIZE> ring;
+    std::thread producer([&] {
+        for (int i = 0; i < frames; ++i) {
+            CanFrame frame = makeFrame(CAN_ID_ENGINE, {(uint8_t)i, (uint8_t)(i >> 8), (uint8_t)(i >> 16)});
+            while (!ring.push(frame)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int expected = 0;
+    bool ordered = true;
+    CanFrame frame;
+    while (expected < frames) {
+        if (!ring.pop(frame)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int value = frame.data[0] | frame.data[1] << 8 | frame.data[2] << 16;
+        ordered &= value == expected;
+        expected++;
+    }
+    producer.join();
+    return expect(ordered && ring.received == (uint32_t)frames, "no loss or reordering");
+#else
+    (void)frames;
+    return true;
+#endif
+}
+
+static void printUsage() {
+    std::cerr << "Usage: CanReplay [--cycles <n>] [--frames <n>]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int cycles = 600;
+    int frames = 200000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cycles" && i + 1 < argc) {
+            cycles = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frames = std::max(1, atoi(argv[++i]));
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    bool ok = checkFilter();
+    ok &= checkReplay(cycles);
+    ok &= checkLengths();
+    ok &= checkOverflow();
+    ok &= checkThreads(frames);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "SerialCommandParser.h"
+
+// Checks the firmware's SerialCommandParser on the host and times it. At
+// 115200 baud a 1 kHz loop() sees at most SERIAL_BYTES_PER_MS bytes per
+// iteration, the report scales the host cost of those by AVR_SLOWDOWN, a
+// deliberately pessimistic guess for a 16 MHz 8 bit core against this
+// machine, and fails when that does not fit LOOP_SHARE of the 1 ms period.
+const double SERIAL_BYTES_PER_MS = 115200.0 / 10 / 1000;
+const double AVR_SLOWDOWN = 500.0;
+const double LOOP_PERIOD_US = 1000.0;
+const double LOOP_SHARE = 0.1;
+
+static long lastAngle = -1;
+static long lastGears[2] = {-1, -1};
+static int shiftCommands = 0;
+
+static void handleGear(const char* args) {
+    long angle;
+    if (parseCommandInt(args, angle)) lastAngle = angle;
+}
+
+static void handleShift(const char* args) {
+    if (parseCommandInts(args, lastGears, 2)) shiftCommands++;
+}
+
+static const SerialCommand commands[] = {
+    {"G:", handleGear},
+    {"X:", handleShift},
+};
+static const uint8_t COMMAND_COUNT = sizeof(commands) / sizeof(commands[0]);
+
+static int feedAll(SerialCommandParser& parser, const std::string& bytes) {
+    int handled = 0;
+    for (char c : bytes) handled += parser.feed(c);
+    return handled;
+}
+
+static bool expect(bool condition, const char* what) {
+    printf("  %-48s %s\n", what, condition ? "ok" : "FAILED");
+    return condition;
+}
+
+static bool checkParser() {
+    printf("parser:\n");
+    SerialCommandParser parser(commands, COMMAND_COUNT);
+    bool ok = expect(feedAll(parser, "G:9") == 0 && feedAll(parser, "0\n") == 1 && lastAngle == 90,
+                     "a line split across reads");
+    ok &= expect(feedAll(parser, "G:45\r\n") == 1 && lastAngle == 45, "CRLF line endings");
+    ok &= expect(feedAll(parser, "  G:120  \n") == 1 && lastAngle == 120, "padding around the line");
+    lastAngle = -1;
+    ok &= expect(feedAll(parser, "G:abc\n") == 1 && lastAngle == -1, "G:abc leaves the angle alone");
+    ok &= expect(feedAll(parser, "G:9999999\n") == 1 && lastAngle == -1, "out of range value is rejected");
+    ok &= expect(feedAll(parser, "X:2,3\n") == 1 && lastGears[0] == 2 && lastGears[1] == 3, "X:<from>,<to>");
+    int shifts = shiftCommands;
+    ok &= expect(feedAll(parser, "X:2,3,4\n") == 1 && shiftCommands == shifts, "X: with a third value is rejected");
+    ok &= expect(feedAll(parser, "Q:1\n") == 0 && parser.getUnknown() == 1, "unknown command is counted");
+    ok &= expect(feedAll(parser, std::string(40, '1') + "\n") == 0 && parser.getOverflows() == 1,
+                 "overlong line is dropped and counted");
+    ok &= expect(feedAll(parser, "G:10\n") == 1 && lastAngle == 10, "next line after an overflow");
+    ok &= expect(feedAll(parser, "\n\r\n") == 0 && parser.getUnknown() == 1, "empty lines are skipped");
+    return ok;
+}
+
+// Best of several rounds, in ns per byte
+static double timeStream(const std::string& stream, int rounds, int& handled) {
+    SerialCommandParser parser(commands, COMMAND_COUNT);
+    double best = 1e30;
+    for (int round = 0; round < rounds; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        handled = feedAll(parser, stream);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ns / stream.size());
+    }
+    return best;
+}
+
+static bool benchmark(int lines, int rounds) {
+    struct Case {
+        const char* name;
+        const char* line;
+        bool dispatched;
+    };
+    const Case cases[] = {
+        {"G:<angle>", "G:135\n", true},
+        {"X:<from>,<to>", "X:3,4\n", true},
+        {"unknown", "S:1,2,3\n", false},
+        {"overlong", "G:0000000000000000000000000000000000000000\n", false},
+    };
+    printf("%d lines per stream, best of %d:\n", lines, rounds);
+    double worstNsPerByte = 0.0;
+    bool ok = true;
+    for (const Case& c : cases) {
+        std::string stream;
+        for (int i = 0; i < lines; ++i) stream += c.line;
+        int handled = 0;
+        double nsPerByte = timeStream(stream, rounds, handled);
+        printf("  %-16s %6.2f ns/byte  %7.1f ns/line\n", c.name, nsPerByte, nsPerByte * strlen(c.line));
+        ok &= handled == (c.dispatched ? lines : 0);
+        worstNsPerByte = std::max(worstNsPerByte, nsPerByte);
+    }
+    ok = expect(ok, "every line handled as expected");
+
+    double hostUs = worstNsPerByte * SERIAL_BYTES_PER_MS / 1000.0;
+    double avrUs = hostUs * AVR_SLOWDOWN;
+    printf("  %.1f bytes per 1 ms loop at 115200 baud: %.3f us here, %.1f us at %.0fx on the AVR\n",
+           SERIAL_BYTES_PER_MS, hostUs, avrUs, AVR_SLOWDOWN);
+    ok &= expect(avrUs <= LOOP_PERIOD_US * LOOP_SHARE, "fits a tenth of a 1 kHz loop");
+    return ok;
+}
+
+static void printUsage() {
+    std::cerr << "Usage: CommandParserBench [--lines <n>] [--rounds <n>]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int lines = 100000;
+    int rounds = 5;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lines" && i + 1 < argc) {
+            lines = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            rounds = std::max(1, atoi(argv[++i]));
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    bool ok = checkParser();
+    ok &= benchmark(lines, rounds);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "Arduino.h"
+#include "Clock.h"
+
+// Stands in for the Arduino with a pty behind a symlink the cluster is
+// pointed at. Every cycle plugs a fresh pty in, streams telemetry, goes quiet
+// until the link turns stale (the renderer shows NO DATA for exactly that
+// flag), resumes and finally unplugs it again.
+const int LINE_PERIOD_MS = 10;
+const int RECONNECT_LIMIT_MS = 100;
+const int RESUME_LIMIT_MS = 50;
+const int UNPLUG_LIMIT_MS = 200;
+const int STALE_SLACK_MS = 150;
+
+struct FakeDevice {
+    int master = -1;
+    int rpm = 1000;
+
+    // The link is swapped with a rename, like udev replacing a by-id link
+    bool plug(const std::string& link) {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+            perror("pty");
+            return false;
+        }
+        std::string staging = link + ".new";
+        unlink(staging.c_str());
+        if (symlink(ptsname(master), staging.c_str()) != 0 || rename(staging.c_str(), link.c_str()) != 0) {
+            perror("symlink");
+            return false;
+        }
+        return true;
+    }
+    void unplug(const std::string& link) {
+        unlink(link.c_str());
+        close(master);
+        master = -1;
+    }
+    void sendLine(const char* line) {
+        write(master, line, strlen(line));
+    }
+    void sendSample() {
+        char line[96];
+        rpm = rpm >= 9000 ? 1000 : rpm + 10;
+        snprintf(line, sizeof(line), "G:3,R:%d,T:90.00,Th:50.00,L:40.00,A:20.00,V:13.80\n", rpm);
+        sendLine(line);
+    }
+};
+
+// Milliseconds until `done` holds, -1 after `limitMs`. Streams telemetry
+// meanwhile when `feeding` is set.
+static int waitFor(FakeDevice& device, bool feeding, int limitMs, const std::function<bool()>& done) {
+    uint64_t startUs = monotonicMicros();
+    uint64_t nextLineUs = startUs;
+    while (true) {
+        uint64_t nowUs = monotonicMicros();
+        if (done()) return (int)((nowUs - startUs) / 1000);
+        if (nowUs - startUs > (uint64_t)limitMs * 1000) return -1;
+        if (feeding && nowUs >= nextLineUs) {
+            device.sendSample();
+            nextLineUs = nowUs + LINE_PERIOD_MS * 1000;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static bool expect(bool condition, const char* what, int ms = -1) {
+    if (ms >= 0) {
+        printf("  %-40s %4d ms  %s\n", what, ms, condition ? "ok" : "FAILED");
+    } else {
+        printf("  %-40s          %s\n", what, condition ? "ok" : "FAILED");
+    }
+    return condition;
+}
+
+static void printUsage() {
+    std::cerr << "Usage: LinkSimulator [--cycles <n>]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int cycles = 5;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cycles" && i + 1 < argc) {
+            cycles = std::max(1, atoi(argv[++i]));
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    char dirTemplate[] = "/tmp/linksim-XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string link = std::string(dirTemplate) + "/ttyArduino";
+    FakeDevice device;
+    bool ok = true;
+    {
+        Arduino arduino("/dinocar-linksim-" + std::to_string(getpid()));
+        arduino.setPort(link);
+        arduino.start();
+        const int staleLimitMs = (int)(LINK_STALE_US / 1000) + STALE_SLACK_MS;
+
+        for (int cycle = 1; cycle <= cycles && ok; ++cycle) {
+            printf("cycle %d:\n", cycle);
+            if (!device.plug(link)) return 1;
+            int ms = waitFor(device, false, RECONNECT_LIMIT_MS, [&] { return arduino.getLinkHealth().connected; });
+            ok &= expect(ms >= 0, "connects after plug", ms);
+
+            ms = waitFor(device, true, RESUME_LIMIT_MS, [&] { return !arduino.getData().stale; });
+            ok &= expect(ms >= 0, "NO DATA clears with the first line", ms);
+            waitFor(device, true, 100, [] { return false; });
+            ok &= expect(arduino.getData().engineRpm == device.rpm || arduino.getData().engineRpm == device.rpm - 10,
+                         "shows the streamed RPM");
+
+            uint64_t parseErrors = arduino.getLinkHealth().parseErrors;
+            device.sendLine("G:3,R:garbage\n");
+            ms = waitFor(device, true, RESUME_LIMIT_MS, [&] { return arduino.getLinkHealth().parseErrors == parseErrors + 1; });
+            ok &= expect(ms >= 0 && !arduino.getData().stale, "counts a bad line, stays fresh", ms);
+
+            ms = waitFor(device, false, staleLimitMs, [&] { return arduino.getData().stale; });
+            ok &= expect(ms >= 0 && arduino.getLinkHealth().connected, "NO DATA once the line goes quiet", ms);
+            ms = waitFor(device, true, RESUME_LIMIT_MS, [&] { return !arduino.getData().stale; });
+            ok &= expect(ms >= 0, "NO DATA clears when lines resume", ms);
+
+            device.unplug(link);
+            ms = waitFor(device, false, UNPLUG_LIMIT_MS, [&] {
+                return !arduino.getLinkHealth().connected && arduino.getData().stale;
+            });
+            ok &= expect(ms >= 0, "disconnect and NO DATA on unplug", ms);
+        }
+
+        LinkHealthSnapshot link = arduino.getLinkHealth();
+        printf("link: %llu connects, %llu frames, %llu parse errors, %llu gaps\n", (unsigned long long)link.reconnects,
+               (unsigned long long)link.frames, (unsigned long long)link.parseErrors, (unsigned long long)link.gaps);
+        ok &= expect(ok && link.reconnects == (uint64_t)cycles, "one connect per plug");
+        arduino.stop();
+    }
+    rmdir(dirTemplate);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,381 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Telemetry.h"
+
+// Offline statistics over a capture of firmware telemetry lines, either raw
+// serial output or the timestamped lines of TelemetryMonitor --follow. The
+// file is mapped and cut into one chunk per thread at line boundaries. Each
+// chunk is reduced on its own, the chunks are then stitched in file order so
+// the results match a single threaded pass.
+const int GEAR_COUNT = GEAR_6 + 1;
+const int RPM_BIN_WIDTH = 1000;
+const int RPM_BINS = RPM_MAX / RPM_BIN_WIDTH + 1;
+// Longer gaps are pauses in the capture, not time spent in a gear
+const double MAX_SAMPLE_GAP_S = 1.0;
+// Old and new gear must be seen within this window to count as one shift
+const double SHIFT_WINDOW_S = 1.0;
+
+struct GearStats {
+    uint64_t samples = 0;
+    double seconds = 0.0;
+    float maxSpeed = 0.0f;
+    uint64_t rpmBins[RPM_BINS] = {};
+};
+
+struct ShiftStats {
+    uint64_t count = 0;
+    double totalS = 0.0;
+    double minS = 1e9;
+    double maxS = 0.0;
+
+    void add(double seconds) {
+        count++;
+        totalS += seconds;
+        minS = std::min(minS, seconds);
+        maxS = std::max(maxS, seconds);
+    }
+    void merge(const ShiftStats& other) {
+        count += other.count;
+        totalS += other.totalS;
+        minS = std::min(minS, other.minS);
+        maxS = std::max(maxS, other.maxS);
+    }
+};
+
+struct Sample {
+    double time;
+    int gear;
+    float speed;
+};
+
+// Last driving gear (1-6) and when it was last seen, carried across chunks
+struct ShiftTracker {
+    int gear = -1;
+    double lastSeen = 0.0;
+};
+
+struct ChunkResult {
+    uint64_t bytes = 0;
+    uint64_t lines = 0;
+    uint64_t samples = 0;
+    uint64_t badLines = 0;
+    bool timestamped = false;
+    GearStats gears[GEAR_COUNT];
+    ShiftStats upShifts;
+    ShiftStats downShifts;
+    float coolantMin = 1e9f, coolantMax = -1e9f;
+    float voltageMin = 1e9f, voltageMax = -1e9f;
+    float maxSpeed = 0.0f;
+    double distanceKm = 0.0;
+    // Boundary samples, in chunk local time unless timestamped
+    Sample first = {0.0, 0, 0.0f};
+    Sample last = {0.0, 0, 0.0f};
+    Sample firstDriving = {0.0, -1, 0.0f};
+    ShiftTracker tail;
+};
+
+static void printUsage() {
+    std::cerr << "Usage: SessionAnalyzer <capture> [--threads <n>] [--rate <hz>] [--scaling]" << std::endl
+              << "  --threads  worker threads, default: all cores" << std::endl
+              << "  --rate     sample rate for lines without a timestamp, default 100 Hz" << std::endl
+              << "  --scaling  parse with 1..n threads and print the throughput of each" << std::endl;
+}
+
+// "<seconds> " prefix as written by TelemetryMonitor --follow
+static bool parseTimestamp(const char*& pos, const char* end, double& seconds) {
+    const char* p = pos;
+    double value = 0.0;
+    while (p < end && *p >= '0' && *p <= '9') value = value * 10.0 + (*p++ - '0');
+    if (p == pos) return false;
+    if (p < end && *p == '.') {
+        double scale = 0.1;
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, scale *= 0.1) value += (*p - '0') * scale;
+    }
+    if (p == end || *p != ' ') return false;
+    seconds = value;
+    pos = p + 1;
+    return true;
+}
+
+static void recordShift(ChunkResult& result, ShiftTracker& tracker, const Sample& sample) {
+    if (sample.gear < 1) return;
+    if (tracker.gear >= 1 && sample.gear != tracker.gear && sample.time - tracker.lastSeen <= SHIFT_WINDOW_S) {
+        (sample.gear > tracker.gear ? result.upShifts : result.downShifts).add(sample.time - tracker.lastSeen);
+    }
+    tracker.gear = sample.gear;
+    tracker.lastSeen = sample.time;
+}
+
+// Time and distance between two consecutive samples belong to the first one
+static void recordInterval(ChunkResult& result, const Sample& previous, const Sample& next) {
+    double dt = next.time - previous.time;
+    if (dt <= 0.0 || dt > MAX_SAMPLE_GAP_S) return;
+    if (previous.gear >= 0 && previous.gear < GEAR_COUNT) {
+        result.gears[previous.gear].seconds += dt;
+    }
+    result.distanceKm += previous.speed * dt / 3600.0;
+}
+
+static void analyzeChunk(const char* begin, const char* end, double rateHz, ChunkResult& result) {
+    result.bytes = end - begin;
+    ShiftTracker tracker;
+    VehicleData data;
+    const char* line = begin;
+    while (line < end) {
+        const char* newline = (const char*)memchr(line, '\n', end - line);
+        const char* lineEnd = newline ? newline : end;
+        result.lines++;
+
+        const char* text = line;
+        double stamp = 0.0;
+        bool hasStamp = parseTimestamp(text, lineEnd, stamp);
+        if (!parseTelemetryLine(text, lineEnd - text, data)) {
+            if (lineEnd > line) result.badLines++;
+            line = lineEnd + 1;
+            continue;
+        }
+
+        Sample sample = {hasStamp ? stamp : result.samples / rateHz, data.currentGear,
+                         calculateSpeed(data.engineRpm, data.currentGear)};
+        if (result.samples == 0) {
+            result.first = sample;
+            result.timestamped = hasStamp;
+        } else {
+            recordInterval(result, result.last, sample);
+        }
+        result.last = sample;
+        result.samples++;
+
+        if (sample.gear >= 0 && sample.gear < GEAR_COUNT) {
+            GearStats& gear = result.gears[sample.gear];
+            gear.samples++;
+            gear.rpmBins[std::clamp(data.engineRpm / RPM_BIN_WIDTH, 0, RPM_BINS - 1)]++;
+            gear.maxSpeed = std::max(gear.maxSpeed, sample.speed);
+        }
+        if (sample.gear >= 1 && result.firstDriving.gear < 0) {
+            result.firstDriving = sample;
+        }
+        recordShift(result, tracker, sample);
+
+        result.maxSpeed = std::max(result.maxSpeed, sample.speed);
+        result.coolantMin = std::min(result.coolantMin, data.coolantTemp);
+        result.coolantMax = std::max(result.coolantMax, data.coolantTemp);
+        // The firmware reports -1 until the first battery reading
+        if (data.voltage >= 0.0f) {
+            result.voltageMin = std::min(result.voltageMin, data.voltage);
+            result.voltageMax = std::max(result.voltageMax, data.voltage);
+        }
+        line = lineEnd + 1;
+    }
+    result.tail = tracker;
+}
+
+// Chunk i+1 started without knowing the gear chunk i ended in, the first
+// interval and the first driving gear change are settled here instead
+static ChunkResult mergeChunks(std::vector<ChunkResult>& chunks, double rateHz) {
+    ChunkResult total;
+    ShiftTracker tracker;
+    uint64_t samplesBefore = 0;
+    bool haveLast = false;
+    for (ChunkResult& chunk : chunks) {
+        double offset = chunk.timestamped ? 0.0 : samplesBefore / rateHz;
+        samplesBefore += chunk.samples;
+        total.bytes += chunk.bytes;
+        total.lines += chunk.lines;
+        total.badLines += chunk.badLines;
+        if (chunk.samples == 0) continue;
+
+        Sample first = chunk.first;
+        first.time += offset;
+        if (haveLast) {
+            recordInterval(total, total.last, first);
+        }
+        if (chunk.firstDriving.gear >= 1) {
+            Sample firstDriving = chunk.firstDriving;
+            firstDriving.time += offset;
+            recordShift(total, tracker, firstDriving);
+        }
+        if (chunk.tail.gear >= 1) {
+            tracker = chunk.tail;
+            tracker.lastSeen += offset;
+        }
+        total.last = chunk.last;
+        total.last.time += offset;
+        if (!haveLast) {
+            total.first = first;
+            total.timestamped = chunk.timestamped;
+        }
+        haveLast = true;
+
+        total.samples += chunk.samples;
+        total.distanceKm += chunk.distanceKm;
+        total.upShifts.merge(chunk.upShifts);
+        total.downShifts.merge(chunk.downShifts);
+        total.maxSpeed = std::max(total.maxSpeed, chunk.maxSpeed);
+        total.coolantMin = std::min(total.coolantMin, chunk.coolantMin);
+        total.coolantMax = std::max(total.coolantMax, chunk.coolantMax);
+        total.voltageMin = std::min(total.voltageMin, chunk.voltageMin);
+        total.voltageMax = std::max(total.voltageMax, chunk.voltageMax);
+        for (int g = 0; g < GEAR_COUNT; ++g) {
+            total.gears[g].samples += chunk.gears[g].samples;
+            total.gears[g].seconds += chunk.gears[g].seconds;
+            total.gears[g].maxSpeed = std::max(total.gears[g].maxSpeed, chunk.gears[g].maxSpeed);
+            for (int b = 0; b < RPM_BINS; ++b) {
+                total.gears[g].rpmBins[b] += chunk.gears[g].rpmBins[b];
+            }
+        }
+    }
+    return total;
+}
+
+// Returns the merged result and the wall time of the parallel part
+static ChunkResult analyze(const char* data, size_t size, int threads, double rateHz, double& seconds) {
+    std::vector<const char*> bounds = {data};
+    for (int i = 1; i < threads; ++i) {
+        const char* cut = std::max(bounds.back(), data + size * i / threads);
+        const char* newline = (const char*)memchr(cut, '\n', data + size - cut);
+        bounds.push_back(newline ? newline + 1 : data + size);
+    }
+    bounds.push_back(data + size);
+
+    std::vector<ChunkResult> chunks(threads);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(analyzeChunk, bounds[i], bounds[i + 1], rateHz, std::ref(chunks[i]));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return mergeChunks(chunks, rateHz);
+}
+
+static void printShifts(const char* name, const ShiftStats& shifts) {
+    if (shifts.count == 0) {
+        printf("  %-5s none\n", name);
+        return;
+    }
+    printf("  %-5s %6llu, mean %6.1f ms, min %6.1f ms, max %6.1f ms\n", name, (unsigned long long)shifts.count,
+           shifts.totalS * 1e3 / shifts.count, shifts.minS * 1e3, shifts.maxS * 1e3);
+}
+
+static void printReport(const ChunkResult& result) {
+    double duration = result.last.time - result.first.time;
+    printf("%llu lines, %llu samples, %llu unparsable, %.1f s of driving data%s\n",
+           (unsigned long long)result.lines, (unsigned long long)result.samples,
+           (unsigned long long)result.badLines, duration, result.timestamped ? "" : " (from --rate)");
+    if (result.samples == 0) return;
+
+    double gearSeconds = 0.0;
+    for (const GearStats& gear : result.gears) gearSeconds += gear.seconds;
+    printf("\n%-4s %10s  %7s  %8s  rpm share per %d rpm bin (%%)\n", "gear", "time", "share", "max km/h", RPM_BIN_WIDTH);
+    printf("%36s", "");
+    for (int b = 0; b < RPM_BINS; ++b) printf("%5dk", b * RPM_BIN_WIDTH / 1000);
+    printf("\n");
+    for (int g = 0; g < GEAR_COUNT; ++g) {
+        const GearStats& gear = result.gears[g];
+        if (gear.samples == 0) continue;
+        printf("%-4s %8.1f s  %5.1f %%  %8.1f  ", g == 0 ? "N" : std::to_string(g).c_str(), gear.seconds,
+               gearSeconds > 0.0 ? gear.seconds * 100.0 / gearSeconds : 0.0, gear.maxSpeed);
+        for (int b = 0; b < RPM_BINS; ++b) {
+            printf("%6.1f", gear.rpmBins[b] * 100.0 / gear.samples);
+        }
+        printf("\n");
+    }
+
+    printf("\nshifts (last sample in the old gear to first in the new one):\n");
+    printShifts("up", result.upShifts);
+    printShifts("down", result.downShifts);
+    printf("\ncoolant  %.1f to %.1f C\n", result.coolantMin, result.coolantMax);
+    if (result.voltageMin <= result.voltageMax) {
+        printf("battery  %.2f to %.2f V\n", result.voltageMin, result.voltageMax);
+    }
+    printf("speed    max %.1f km/h, %.2f km covered\n", result.maxSpeed, result.distanceKm);
+}
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    double rateHz = 100.0;
+    bool scaling = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        char* end = nullptr;
+        if (arg == "--threads" && i + 1 < argc) {
+            long value = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || value < 1 || value > 1024) {
+                printUsage();
+                return 1;
+            }
+            threads = (int)value;
+        } else if (arg == "--rate" && i + 1 < argc) {
+            rateHz = strtod(argv[++i], &end);
+            if (*end != '\0' || !(rateHz > 0.0 && rateHz < 1e6)) {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--scaling") {
+            scaling = true;
+        } else if (path.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        std::cerr << "Cannot open " << path << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    size_t size = info.st_size;
+    if (size == 0) {
+        std::cerr << path << " is empty" << std::endl;
+        return 1;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "mmap failed: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    // Separate calls, the advice values are not flags
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    madvise(mapping, size, MADV_WILLNEED);
+    const char* data = (const char*)mapping;
+
+    double seconds;
+    if (scaling) {
+        // The first pass only pulls the file into the page cache
+        analyze(data, size, threads, rateHz, seconds);
+        for (int n = 1; ; n = std::min(n * 2, threads)) {
+            analyze(data, size, n, rateHz, seconds);
+            printf("%2d threads: %8.1f MB/s\n", n, size / seconds / 1e6);
+            if (n == threads) break;
+        }
+    }
+    ChunkResult result = analyze(data, size, threads, rateHz, seconds);
+    printReport(result);
+    printf("\nparsed %.1f MB in %.3f s with %d threads: %.1f MB/s\n", size / 1e6, seconds, threads, size / seconds / 1e6);
+    munmap(mapping, size);
+    return 0;
+}
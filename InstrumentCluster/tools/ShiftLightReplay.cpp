@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "ShiftPredictor.h"
+
+// Replays full throttle runs through first to sixth gear sample by sample
+// into the ShiftPredictor and measures when the driver sees the shift light
+// against the moment the true RPM crosses WARNING_LIGHTS_RPM. Negative is
+// early. The light shows up one serial line, one frame wait and the render
+// after the CAN sample, the predictor is fed the parse to present latency the
+// way Renderer measures it.
+const uint64_t TELEMETRY_PERIOD_US = 20000;
+const uint64_t TELEMETRY_JITTER_US = 4000;
+const uint64_t FRAME_PERIOD_US = 16667;
+const uint64_t RENDER_US = 6000;
+const uint64_t GEAR_CHANGE_US = 120000;
+const int SHIFT_RPM = 8200;
+const int LAUNCH_RPM = 3000;
+const int RPM_NOISE = 40;
+const float MIN_FIRST_GEAR_RATE = 3000.0f;
+const float MAX_FIRST_GEAR_RATE = 9000.0f;
+
+// Allowed error of the light as seen by the driver, in ms
+const double MAX_MEAN_ERROR_MS = 10.0;
+const double MAX_LATE_P95_MS = 40.0;
+const double MAX_EARLY_P5_MS = -50.0;
+// Predicted RPM over the first samples of a gear, where the learned per-gear
+// rate stands in for the short fit
+const int EARLY_SAMPLES = SHIFT_PREDICTION_MIN_FIT - 1;
+const double MAX_EARLY_RPM_ERROR = 42.0;
+
+struct Errors {
+    std::vector<double> ms;
+    int missed = 0;
+
+    void print(const char* name) {
+        if (ms.empty()) {
+            printf("  %-22s no light seen, %d missed\n", name, missed);
+            return;
+        }
+        std::sort(ms.begin(), ms.end());
+        printf("  %-22s mean %6.1f ms  p5 %6.1f ms  p95 %6.1f ms  max %6.1f ms  %d missed\n", name, mean(),
+               percentile(5), percentile(95), ms.back(), missed);
+    }
+    double mean() const {
+        double sum = 0.0;
+        for (double value : ms) sum += value;
+        return ms.empty() ? 0.0 : sum / ms.size();
+    }
+    double percentile(int p) const { return ms.empty() ? 0.0 : ms[std::min(ms.size() - 1, ms.size() * p / 100)]; }
+};
+
+// Torque drops towards the limiter, RPM rises slower in higher gears by the
+// square of the ratio
+static float rpmRate(float firstGearRate, int gear, float rpm) {
+    float ratio = GEAR_RATIOS[gear - 1] / GEAR_RATIOS[0];
+    return firstGearRate * ratio * ratio * (1.15f - 0.3f * rpm / 9000.0f);
+}
+
+// When the true RPM of a pull starting now reaches the light threshold
+static uint64_t crossingUs(float firstGearRate, int gear, float rpm, uint64_t nowUs, uint64_t stepUs) {
+    while (rpm < WARNING_LIGHTS_RPM) {
+        rpm += rpmRate(firstGearRate, gear, rpm) * stepUs / 1e6f;
+        nowUs += stepUs;
+    }
+    return nowUs;
+}
+
+// True RPM `aheadUs` from now, as long as the pull goes on
+static float rpmAhead(float firstGearRate, int gear, float rpm, uint64_t aheadUs, uint64_t stepUs) {
+    for (uint64_t t = 0; t < aheadUs; t += stepUs) {
+        rpm += rpmRate(firstGearRate, gear, rpm) * stepUs / 1e6f;
+    }
+    return rpm;
+}
+
+struct EarlyErrors {
+    double predicted = 0.0;
+    double held = 0.0;
+    int samples = 0;
+};
+
+// One run with the true RPM stepped in 0.1 ms, the telemetry samples taken
+// from it with noise and jitter
+static void replayRun(float firstGearRate, std::mt19937& rng, Errors& predicted, Errors& threshold,
+                      std::vector<Errors>& perGear, EarlyErrors& early) {
+    std::uniform_int_distribution<int> noise(-RPM_NOISE, RPM_NOISE);
+    std::uniform_int_distribution<uint64_t> jitter(0, TELEMETRY_JITTER_US);
+    std::uniform_int_distribution<uint64_t> framePhase(0, FRAME_PERIOD_US - 1);
+    const uint64_t stepUs = 100;
+
+    ShiftPredictor predictor;
+    int gear = GEAR_1;
+    float rpm = LAUNCH_RPM;
+    uint64_t crossUs = crossingUs(firstGearRate, gear, rpm, 0, stepUs);
+    uint64_t shiftStartUs = 0, nextSampleUs = 0, displayLatencyUs = 0;
+    uint64_t vsyncPhaseUs = framePhase(rng);
+    bool predictedSeen = false, thresholdSeen = false;
+    float shiftFromRpm = 0.0f;
+    int gearSamples = 0;
+
+    for (uint64_t nowUs = 0;; nowUs += stepUs) {
+        if (shiftStartUs) {
+            // Clutch in, RPM falls to the next gear's speed, then the gear shows up
+            float targetRpm = shiftFromRpm * GEAR_RATIOS[gear] / GEAR_RATIOS[gear - 1];
+            float progress = std::min(1.0f, (float)(nowUs - shiftStartUs) / GEAR_CHANGE_US);
+            rpm = shiftFromRpm + (targetRpm - shiftFromRpm) * progress;
+            if (progress >= 1.0f) {
+                if (!predictedSeen) {
+                    predicted.missed++;
+                    perGear[gear - 1].missed++;
+                }
+                if (!thresholdSeen) threshold.missed++;
+                gear++;
+                shiftStartUs = 0;
+                crossUs = crossingUs(firstGearRate, gear, rpm, nowUs, stepUs);
+                gearSamples = 0;
+                predictedSeen = thresholdSeen = false;
+            }
+        } else {
+            rpm += rpmRate(firstGearRate, gear, rpm) * stepUs / 1e6f;
+            if (rpm >= SHIFT_RPM) {
+                if (gear == GEAR_6) break;
+                shiftStartUs = nowUs;
+                shiftFromRpm = rpm;
+            }
+        }
+
+        if (nowUs < nextSampleUs) continue;
+        nextSampleUs = nowUs + TELEMETRY_PERIOD_US - TELEMETRY_JITTER_US / 2 + jitter(rng);
+
+        // Parsed one line later, presented after the render and the next vsync
+        uint64_t parseUs = nowUs + SERIAL_LINE_LATENCY_US;
+        uint64_t presentUs = parseUs + RENDER_US;
+        presentUs += (FRAME_PERIOD_US - (presentUs + vsyncPhaseUs) % FRAME_PERIOD_US) % FRAME_PERIOD_US;
+        uint64_t latencyUs = presentUs - parseUs;
+        displayLatencyUs = displayLatencyUs ? (displayLatencyUs * 7 + latencyUs) / 8 : latencyUs;
+        predictor.setDisplayLatency(displayLatencyUs);
+
+        int reportedRpm = (int)rpm + noise(rng);
+        predictor.addSample(parseUs, reportedRpm, gear);
+        if (shiftStartUs) continue;
+
+        // Where the RPM will be when this sample shows, against the fitted
+        // slope alone (zero from one sample) holding the reported value
+        if (gear > GEAR_1 && ++gearSamples <= EARLY_SAMPLES) {
+            float truthRpm = rpmAhead(firstGearRate, gear, rpm, parseUs + predictor.getLeadTimeUs() - nowUs, stepUs);
+            early.predicted += std::abs(predictor.getPredictedRpm() - truthRpm);
+            early.held += std::abs(reportedRpm - truthRpm);
+            early.samples++;
+        }
+        if (gear == GEAR_6) continue;
+
+        double errorMs = ((double)presentUs - (double)crossUs) / 1000.0;
+        if (!predictedSeen && predictor.isShiftLightOn()) {
+            predictedSeen = true;
+            predicted.ms.push_back(errorMs);
+            perGear[gear - 1].ms.push_back(errorMs);
+        }
+        if (!thresholdSeen && reportedRpm >= WARNING_LIGHTS_RPM) {
+            thresholdSeen = true;
+            threshold.ms.push_back(errorMs);
+        }
+    }
+}
+
+static void printUsage() {
+    std::cerr << "Usage: ShiftLightReplay [--runs <n>] [--seed <n>]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int runs = 200;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = (unsigned)atoi(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> firstGearRate(MIN_FIRST_GEAR_RATE, MAX_FIRST_GEAR_RATE);
+    Errors predicted, threshold;
+    std::vector<Errors> perGear(GEAR_5);
+    EarlyErrors early;
+    for (int i = 0; i < runs; ++i) {
+        replayRun(firstGearRate(rng), rng, predicted, threshold, perGear, early);
+    }
+
+    printf("%d full throttle runs, 1st gear %.0f-%.0f rpm/s, light at %d rpm, telemetry every %llu ms:\n", runs,
+           MIN_FIRST_GEAR_RATE, MAX_FIRST_GEAR_RATE, WARNING_LIGHTS_RPM, (unsigned long long)TELEMETRY_PERIOD_US / 1000);
+    predicted.print("predicted light");
+    for (int gear = GEAR_1; gear <= GEAR_5; ++gear) {
+        std::string name = "  in gear " + std::to_string(gear);
+        perGear[gear - 1].print(name.c_str());
+    }
+    threshold.print("threshold on samples");
+
+    double earlyError = early.samples ? early.predicted / early.samples : 0.0;
+    printf("  first %d samples in a gear: predicted rpm off by %.0f on average, %.0f holding the sample\n",
+           EARLY_SAMPLES, earlyError, early.samples ? early.held / early.samples : 0.0);
+
+    bool ok = predicted.missed == 0 && std::abs(predicted.mean()) <= MAX_MEAN_ERROR_MS
+              && predicted.percentile(95) <= MAX_LATE_P95_MS && predicted.percentile(5) >= MAX_EARLY_P5_MS
+              && earlyError <= MAX_EARLY_RPM_ERROR;
+    printf("  limits: |mean| <= %.0f ms, p95 <= %.0f ms, p5 >= %.0f ms, none missed, early rpm <= %.0f  %s\n",
+           MAX_MEAN_ERROR_MS, MAX_LATE_P95_MS, MAX_EARLY_P5_MS, MAX_EARLY_RPM_ERROR, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
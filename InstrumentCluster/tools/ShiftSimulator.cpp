@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "ShiftExecutor.h"
+
+// Host model of the shift loop. The gearbox engages after the lever was held
+// for a random time, the gear shows up in the next 0x540 frame. The firmware
+// path runs the real ShiftExecutor against that, the cluster path models the
+// old round trip of telemetry line, render frame and G: command.
+const int CAN_FRAME_PERIOD_MS = 10;
+const double TELEMETRY_LINE_MS = 55 * 10 / 115.2;
+const double COMMAND_LINE_MS = 5 * 10 / 115.2;
+const double CLUSTER_FRAME_MS = 17.0;
+const int ENGAGE_MIN_MS = 40;
+const int ENGAGE_MAX_MS = 140;
+
+struct Stats {
+    std::vector<double> samples;
+
+    void add(double value) { samples.push_back(value); }
+    void print(const char* name) {
+        if (samples.empty()) return;
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double value : samples) sum += value;
+        printf("  %-28s mean %6.1f ms  p95 %6.1f ms  max %6.1f ms\n", name, sum / samples.size(),
+               samples[samples.size() * 95 / 100], samples.back());
+    }
+};
+
+static void printUsage() {
+    std::cerr << "Usage: ShiftSimulator [--shifts <n>] [--seed <n>]" << std::endl;
+}
+
+static bool expect(bool condition, const char* what) {
+    printf("  %-44s %s\n", what, condition ? "ok" : "FAILED");
+    return condition;
+}
+
+// Steps the executor in 1 ms ticks until it is idle again, with the gear
+// nibble switching to `engagedGear` once `engageMs` passed (never if < 0).
+static ShiftReport runShift(ShiftExecutor& executor, uint8_t from, uint8_t to, int engageMs, int framePhaseMs,
+                            int* returnMs = nullptr) {
+    ShiftReport report = {from, to, SHIFT_REJECTED, 0};
+    uint8_t gear = from;
+    if (!executor.start(from, to, gear, 0)) {
+        executor.takeReport(report);
+        return report;
+    }
+    int pushAngle = executor.getServoAngle();
+    for (uint32_t now = 1; executor.isBusy() && now < 5000; ++now) {
+        if (engageMs >= 0 && (int)now >= engageMs) gear = to;
+        if ((now + framePhaseMs) % CAN_FRAME_PERIOD_MS == 0) executor.onGear(gear, now);
+        executor.update(now);
+        if (returnMs && *returnMs < 0 && executor.getServoAngle() != pushAngle) *returnMs = now;
+        executor.takeReport(report);
+    }
+    return report;
+}
+
+static bool checkStateMachine() {
+    printf("state machine:\n");
+    bool ok = true;
+    ShiftExecutor executor;
+    ShiftReport report;
+
+    ok &= expect(ShiftExecutor::shiftAngle(2, 3) == SERVO_SHIFT_UP_ANGLE, "up shift pushes to the up angle");
+    ok &= expect(ShiftExecutor::shiftAngle(0, 1) == SERVO_SHIFT_DOWN_ANGLE, "N -> 1 pushes down");
+    ok &= expect(ShiftExecutor::returnAngle(2, 3) == SERVO_NEUTRAL_ANGLE + SERVO_BACKLASH_COMPENSATION, "up shift returns past neutral");
+    ok &= expect(ShiftExecutor::returnAngle(0, 1) == SERVO_NEUTRAL_ANGLE - SERVO_BACKLASH_COMPENSATION, "N -> 1 returns like a down shift");
+
+    report = runShift(executor, 2, 3, 60, 0);
+    ok &= expect(report.result == SHIFT_ENGAGED && report.durationMs == 60, "engages on the first frame with the gear");
+    ok &= expect(executor.getServoAngle() == SERVO_DETACHED, "servo released after the hold");
+
+    report = runShift(executor, 3, 4, -1, 0);
+    ok &= expect(report.result == SHIFT_TIMEOUT && report.durationMs == SHIFT_TIMEOUT_MS, "times out without the gear");
+
+    ok &= expect(!executor.start(3, 5, 3, 0), "rejects a two gear jump");
+    ok &= expect(executor.takeReport(report) && report.result == SHIFT_REJECTED, "reports the rejection");
+    ok &= expect(!executor.start(3, 4, 2, 0), "rejects a stale from gear");
+    executor.takeReport(report);
+
+    executor.start(4, 5, 4, 0);
+    ok &= expect(!executor.start(4, 5, 4, 1), "rejects while busy");
+    ok &= expect(executor.takeReport(report) && report.result == SHIFT_REJECTED, "busy rejection is reported");
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int shifts = 10000;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--shifts" && i + 1 < argc) {
+            shifts = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = (unsigned)atoi(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    bool ok = checkStateMachine();
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> engage(ENGAGE_MIN_MS, ENGAGE_MAX_MS);
+    std::uniform_int_distribution<int> phase(0, CAN_FRAME_PERIOD_MS - 1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    Stats firmwareDuration, firmwareOverPush, clusterOverPush;
+    ShiftExecutor executor;
+    for (int i = 0; i < shifts; ++i) {
+        int engageMs = engage(rng);
+        int framePhaseMs = phase(rng);
+        int returnMs = -1;
+        ShiftReport report = runShift(executor, 2, 3, engageMs, framePhaseMs, &returnMs);
+        if (report.result != SHIFT_ENGAGED) {
+            ok = false;
+            continue;
+        }
+        firmwareDuration.add(report.durationMs);
+        firmwareOverPush.add(returnMs - engageMs);
+
+        // Same frame, then the line goes out, waits for the next render
+        // frame and the command for the next byte the serial thread sees
+        double seenMs = report.durationMs + TELEMETRY_LINE_MS + unit(rng) * CLUSTER_FRAME_MS;
+        double sentMs = seenMs + unit(rng) * CAN_FRAME_PERIOD_MS + COMMAND_LINE_MS;
+        clusterOverPush.add(sentMs - engageMs);
+    }
+
+    printf("%d shifts, engagement after %d-%d ms, 0x540 every %d ms:\n", shifts, ENGAGE_MIN_MS, ENGAGE_MAX_MS, CAN_FRAME_PERIOD_MS);
+    firmwareDuration.print("firmware shift duration");
+    firmwareOverPush.print("lever held past engagement");
+    clusterOverPush.print("same via cluster round trip");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TelemetryBus.h"
+
+static void printUsage() {
+    std::cerr << "Usage: TelemetryMonitor [--bus <name>] [--follow] [--bench <readers>]" << std::endl
+              << "  (default)  show the latest sample, refreshed every 100 ms" << std::endl
+              << "  --follow   print every sample as a timestamped telemetry line" << std::endl
+              << "  --bench    measure publish cost and reader throughput on a private bus" << std::endl;
+}
+
+static void printLine(FILE* out, const VehicleData& data) {
+    fprintf(out, "%.6f G:%d,R:%d,T:%.2f,Th:%.2f,L:%.2f,A:%.2f,V:%.2f\n",
+            data.sampleTimeUs / 1e6, data.currentGear, data.engineRpm, data.coolantTemp,
+            data.throttle, data.engineLoad, data.ambientTemp, data.voltage);
+}
+
+struct BenchResult {
+    double seconds;
+    std::vector<uint64_t> received;
+    std::vector<uint64_t> dropped;
+    // From the first to the last record each reader got
+    std::vector<double> readSeconds;
+
+    double rate(int reader) const {
+        return readSeconds[reader] > 0.0 ? received[reader] / readSeconds[reader] : 0.0;
+    }
+};
+
+// Publishes `samples` records, optionally paced to `rateHz`, while `readerCount`
+// threads drain the bus through their own TelemetryReader.
+static BenchResult runPublisher(const std::string& name, int readerCount, uint64_t samples, int rateHz) {
+    TelemetryPublisher publisher(name);
+    BenchResult result{0.0, std::vector<uint64_t>(readerCount, 0), std::vector<uint64_t>(readerCount, 0),
+                       std::vector<double>(readerCount, 0.0)};
+    if (!publisher.isOpen()) return result;
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < readerCount; ++i) {
+        readers.emplace_back([&, i] {
+            TelemetryReader reader(name);
+            TelemetryRecord batch[64];
+            std::chrono::steady_clock::time_point first, last;
+            auto drain = [&] {
+                int n = reader.read(batch, 64);
+                if (n > 0) {
+                    last = std::chrono::steady_clock::now();
+                    if (result.received[i] == 0) first = last;
+                    result.received[i] += n;
+                }
+                return n;
+            };
+            while (!done) {
+                drain();
+            }
+            while (drain() > 0) {
+            }
+            result.dropped[i] = reader.getDropped();
+            result.readSeconds[i] = std::chrono::duration<double>(last - first).count();
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    VehicleData data;
+    double publishSeconds = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < samples; ++i) {
+        if (rateHz > 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(i * 1000000 / rateHz));
+        }
+        data.engineRpm = (int)(i % RPM_MAX);
+        data.sampleTimeUs = i;
+        auto before = std::chrono::steady_clock::now();
+        publisher.publish(data);
+        publishSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - before).count();
+    }
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    result.seconds = publishSeconds;
+    return result;
+}
+
+static int runBenchmark(int readerCount) {
+    const std::string name = "/dinocar-telemetry-bench";
+
+    // Flat out: cost of a publish while readers hammer the same cache lines
+    const uint64_t burstSamples = 2000000;
+    BenchResult burst = runPublisher(name, readerCount, burstSamples, 0);
+    printf("burst:  %.1f ns/publish with %d readers\n", burst.seconds * 1e9 / burstSamples, readerCount);
+    for (int i = 0; i < readerCount; ++i) {
+        printf("  reader %d: %llu received, %llu dropped, %.2f M records/s\n", i,
+               (unsigned long long)burst.received[i], (unsigned long long)burst.dropped[i], burst.rate(i) / 1e6);
+    }
+
+    // Paced well above the serial link rate: every reader has to see every record
+    const int rateHz = 20000;
+    const uint64_t pacedSamples = rateHz;
+    BenchResult paced = runPublisher(name, readerCount, pacedSamples, rateHz);
+    printf("paced:  %.1f ns/publish at %d Hz\n", paced.seconds * 1e9 / pacedSamples, rateHz);
+    int failures = 0;
+    for (int i = 0; i < readerCount; ++i) {
+        printf("  reader %d: %llu received, %llu dropped, %.0f records/s\n", i,
+               (unsigned long long)paced.received[i], (unsigned long long)paced.dropped[i], paced.rate(i));
+        if (paced.received[i] != pacedSamples) failures++;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    std::string name = TELEMETRY_BUS_NAME;
+    bool follow = false;
+    int benchReaders = -1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--bus" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (arg == "--follow") {
+            follow = true;
+        } else if (arg == "--bench" && i + 1 < argc) {
+            char* end;
+            long readers = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || readers < 0 || readers > 64) {
+                printUsage();
+                return 1;
+            }
+            benchReaders = (int)readers;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (benchReaders >= 0) {
+        return runBenchmark(benchReaders);
+    }
+
+    TelemetryReader reader(name);
+    if (!reader.isOpen()) {
+        std::cerr << "No telemetry bus at " << name << ", is the cluster running?" << std::endl;
+        return 1;
+    }
+
+    if (follow) {
+        TelemetryRecord batch[64];
+        uint64_t reportedDrops = 0;
+        while (true) {
+            int n = reader.read(batch, 64);
+            for (int i = 0; i < n; ++i) {
+                printLine(stdout, batch[i].data);
+            }
+            if (reader.getDropped() != reportedDrops) {
+                reportedDrops = reader.getDropped();
+                std::cerr << "dropped " << reportedDrops << " records" << std::endl;
+            }
+            fflush(stdout);
+            if (n == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+    }
+
+    VehicleData data;
+    while (true) {
+        if (reader.readLatest(data)) {
+            printf("\rGear %d | %5d rpm | coolant %5.1f C | throttle %5.1f %% | load %5.1f %% | ambient %5.1f C | %5.2f V ",
+                   data.currentGear, data.engineRpm, data.coolantTemp, data.throttle,
+                   data.engineLoad, data.ambientTemp, data.voltage);
+            fflush(stdout);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
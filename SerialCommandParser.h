@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+const uint8_t SERIAL_COMMAND_BUFFER = 32;
+
+// Called with the text after the prefix, trimmed and null terminated
+typedef void (*SerialCommandHandler)(const char* args);
+
+struct SerialCommand {
+  const char* prefix;
+  SerialCommandHandler handler;
+};
+
+// Reads a decimal integer and leaves text on the first character after it
+inline bool parseCommandIntPrefix(const char*& text, long& value) {
+  bool negative = false;
+  if (*text == '-' || *text == '+') negative = *text++ == '-';
+  if (*text < '0' || *text > '9') return false;
+  long result = 0;
+  while (*text >= '0' && *text <= '9') {
+    result = result * 10 + (*text++ - '0');
+    if (result > 1000000L) return false;
+  }
+  value = negative ? -result : result;
+  return true;
+}
+
+// Strict decimal integer, no allocation. Rejects empty input and trailing junk.
+inline bool parseCommandInt(const char* text, long& value) {
+  return parseCommandIntPrefix(text, value) && *text == '\0';
+}
+
+// Exactly count comma separated integers, e.g. "2,3"
+inline bool parseCommandInts(const char* text, long* values, uint8_t count) {
+  for (uint8_t i = 0; i < count; ++i) {
+    if (i > 0 && *text++ != ',') return false;
+    if (!parseCommandIntPrefix(text, values[i])) return false;
+  }
+  return *text == '\0';
+}
+
+// Line based command parser fed one byte at a time, so loop() never waits
+// for the rest of a line. Lines longer than the buffer are dropped whole.
+class SerialCommandParser {
+public:
+  SerialCommandParser(const SerialCommand* commands, uint8_t count) : commands(commands), count(count) {}
+
+  // Returns true when the byte completed a line that matched a command
+  bool feed(char c) {
+    if (c == '\r') return false;
+    if (c != '\n') {
+      if (length < SERIAL_COMMAND_BUFFER - 1) buffer[length++] = c;
+      else overflow = true;
+      return false;
+    }
+    bool handled = false;
+    if (overflow) overflows++;
+    else if (length > 0) handled = dispatch();
+    length = 0;
+    overflow = false;
+    return handled;
+  }
+
+  uint16_t getOverflows() const { return overflows; }
+  uint16_t getUnknown() const { return unknown; }
+private:
+  bool dispatch() {
+    while (length > 0 && buffer[length - 1] == ' ') length--;
+    buffer[length] = '\0';
+    const char* line = buffer;
+    while (*line == ' ') line++;
+    for (uint8_t i = 0; i < count; ++i) {
+      size_t prefixLength = strlen(commands[i].prefix);
+      if (strncmp(line, commands[i].prefix, prefixLength) == 0) {
+        commands[i].handler(line + prefixLength);
+        return true;
+      }
+    }
+    unknown++;
+    return false;
+  }
+
+  const SerialCommand* commands;
+  uint8_t count;
+  char buffer[SERIAL_COMMAND_BUFFER];
+  uint8_t length = 0;
+  bool overflow = false;
+  uint16_t overflows = 0;
+  uint16_t unknown = 0;
+};
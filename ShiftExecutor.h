@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+
+// Servo geometry of the shift linkage
+const int SERVO_NEUTRAL_ANGLE = 86;
+const int SERVO_SHIFT_UP_ANGLE = SERVO_NEUTRAL_ANGLE - 32;
+const int SERVO_SHIFT_DOWN_ANGLE = SERVO_NEUTRAL_ANGLE + 25;
+const int SERVO_BACKLASH_COMPENSATION = 4;
+const int SERVO_DETACHED = -1;
+
+const uint8_t SHIFT_GEAR_MAX = 6;
+const uint32_t SHIFT_TIMEOUT_MS = 1000;
+const uint32_t SHIFT_HOLD_MS = 400;
+
+enum ShiftResult : uint8_t {
+  SHIFT_ENGAGED,
+  SHIFT_TIMEOUT,
+  SHIFT_REJECTED
+};
+
+struct ShiftReport {
+  uint8_t fromGear;
+  uint8_t toGear;
+  ShiftResult result;
+  uint32_t durationMs;
+};
+
+// Runs one shift next to the CAN decoder: pushes the lever, watches the gear
+// nibble of 0x540 and returns the lever the moment the target gear shows up,
+// slightly past neutral to take up the linkage backlash. The servo is
+// released SHIFT_HOLD_MS later. Time is passed in, so the same code runs in
+// the host simulation.
+class ShiftExecutor {
+public:
+  // Accepts a single step from the gear the car is in right now
+  bool start(uint8_t from, uint8_t to, uint8_t currentGear, uint32_t nowMs) {
+    bool valid = from <= SHIFT_GEAR_MAX && to <= SHIFT_GEAR_MAX && (to == from + 1 || to + 1 == from);
+    if (state != IDLE || !valid || from != currentGear) {
+      queueReport(from, to, SHIFT_REJECTED, 0);
+      return false;
+    }
+    fromGear = from;
+    toGear = to;
+    startMs = nowMs;
+    angle = shiftAngle(from, to);
+    state = PUSHING;
+    return true;
+  }
+
+  // Call for every decoded 0x540 frame
+  void onGear(uint8_t gear, uint32_t nowMs) {
+    if (state == PUSHING && gear == toGear) finish(SHIFT_ENGAGED, nowMs);
+  }
+
+  // Call every loop() for the timeout and the servo release
+  void update(uint32_t nowMs) {
+    if (state == PUSHING && nowMs - startMs >= SHIFT_TIMEOUT_MS) {
+      finish(SHIFT_TIMEOUT, nowMs);
+    } else if (state == HOLDING && nowMs - holdStartMs >= SHIFT_HOLD_MS) {
+      angle = SERVO_DETACHED;
+      state = IDLE;
+    }
+  }
+
+  bool isBusy() const { return state != IDLE; }
+  int getServoAngle() const { return angle; }
+
+  bool takeReport(ShiftReport& out) {
+    if (!reportPending) return false;
+    out = report;
+    reportPending = false;
+    return true;
+  }
+
+  static int shiftAngle(uint8_t from, uint8_t to) {
+    if (from == 0 && to == 1) return SERVO_SHIFT_DOWN_ANGLE;
+    if (from == 1 && to == 0) return SERVO_SHIFT_UP_ANGLE;
+    if (from == 2 && to == 0) return SERVO_SHIFT_DOWN_ANGLE - 13;
+    return to > from ? SERVO_SHIFT_UP_ANGLE : SERVO_SHIFT_DOWN_ANGLE;
+  }
+
+  // N -> 1 counts as a down shift, that is where the lever went
+  static int returnAngle(uint8_t from, uint8_t to) {
+    bool up = to > from && from != 0;
+    return SERVO_NEUTRAL_ANGLE + (up ? SERVO_BACKLASH_COMPENSATION : -SERVO_BACKLASH_COMPENSATION);
+  }
+private:
+  enum State : uint8_t { IDLE, PUSHING, HOLDING };
+
+  void finish(ShiftResult result, uint32_t nowMs) {
+    queueReport(fromGear, toGear, result, nowMs - startMs);
+    angle = returnAngle(fromGear, toGear);
+    holdStartMs = nowMs;
+    state = HOLDING;
+  }
+
+  void queueReport(uint8_t from, uint8_t to, ShiftResult result, uint32_t durationMs) {
+    report = { from, to, result, durationMs };
+    reportPending = true;
+  }
+
+  State state = IDLE;
+  uint8_t fromGear = 0;
+  uint8_t toGear = 0;
+  uint32_t startMs = 0;
+  uint32_t holdStartMs = 0;
+  int angle = SERVO_DETACHED;
+  ShiftReport report;
+  bool reportPending = false;
+};
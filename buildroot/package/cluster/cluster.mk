@@ -21,6 +21,7 @@ endef
 
 define CLUSTER_INSTALL_TARGET_CMDS
 	$(INSTALL) -D -m 0755 $(@D)/build/Cluster $(TARGET_DIR)/usr/bin/cluster
+	$(INSTALL) -D -m 0755 $(@D)/build/TelemetryMonitor $(TARGET_DIR)/usr/bin/telemetry-monitor
 	mkdir -p $(TARGET_DIR)/usr/share/cluster/assets
 	cp -r $(@D)/assets/* $(TARGET_DIR)/usr/share/cluster/assets/
 endef